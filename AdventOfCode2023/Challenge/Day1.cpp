@@ -1,24 +1,23 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day1
 {
-    std::vector<std::string> loadInput( std::istream& stream )
-    {
-        std::vector<std::string> data;
-        for( std::string line; std::getline( stream, line ); )
-            data.push_back( line );
-        return data;
-    }
     int64_t toDigit( char c )
     {
         return c - '0';
     }
 
-    int64_t getCalibrationValue( const std::string& line )
+    bool isDigit( char c )
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    int64_t getCalibrationValue( std::string_view line )
     {
-        const auto firstDigit = std::ranges::find_if( line, [] ( char c )-> bool { return std::isdigit( c ); } );
+        const auto firstDigit = std::ranges::find_if( line, isDigit );
         const auto reversedLine = line | std::views::reverse;
-        const auto lastDigit = std::ranges::find_if( line | std::views::reverse, [] ( char c )-> bool { return std::isdigit( c ); } );
+        const auto lastDigit = std::ranges::find_if( reversedLine, isDigit );
 
         if( firstDigit == line.end() || lastDigit == reversedLine.end() )
             throw std::runtime_error( "invalid line" );
@@ -26,63 +25,68 @@ namespace Day1
         return toDigit( *firstDigit ) * 10 + toDigit( *lastDigit );
     }
 
-    std::pair<std::pair<size_t, int64_t>, std::pair<size_t, int64_t>> findWrittenNumber( std::string line )
+    // Digit or digit word starting at the front of text. The first character selects the only words that can match,
+    // so every position costs one switch and at most two comparisons.
+    std::optional<int64_t> getDigitAtFront( std::string_view text )
     {
-        using AlphaDigit = std::pair<std::string_view, int64_t>;
-        constexpr std::array<AlphaDigit, 9> digitWords = { AlphaDigit{"one", 1},  AlphaDigit{"two", 2},  AlphaDigit{"three", 3},  AlphaDigit{"four", 4},  AlphaDigit{"five", 5},  AlphaDigit{"six", 6},  AlphaDigit{"seven", 7},  AlphaDigit{"eight", 8},  AlphaDigit{"nine", 9} };
-        std::pair<size_t, int64_t> minAlphaDigit{ std::string::npos, 0 };
-        std::pair<size_t, int64_t> maxAlphaDigit{ 0, 0 };
-        for( auto& [name, value] : digitWords )
+        auto ifWord = [ & ] ( std::string_view word, int64_t value ) -> std::optional<int64_t> {
+            return text.starts_with( word ) ? std::optional{ value } : std::nullopt;
+            };
+        switch( text.front() )
         {
-            auto first = line.find( name );
-            auto last = line.rfind( name );
-            if( first == std::string::npos )
-                continue;
-            if( first < minAlphaDigit.first )
-                minAlphaDigit = { first, value };
-            if( last > maxAlphaDigit.first )
-                maxAlphaDigit = { last, value };
+            case 'o':
+                return ifWord( "one", 1 );
+            case 't':
+                return ifWord( "two", 2 ).or_else( [ & ] { return ifWord( "three", 3 ); } );
+            case 'f':
+                return ifWord( "four", 4 ).or_else( [ & ] { return ifWord( "five", 5 ); } );
+            case 's':
+                return ifWord( "six", 6 ).or_else( [ & ] { return ifWord( "seven", 7 ); } );
+            case 'e':
+                return ifWord( "eight", 8 );
+            case 'n':
+                return ifWord( "nine", 9 );
+            default:
+                if( isDigit( text.front() ) )
+                    return toDigit( text.front() );
+                return std::nullopt;
         }
-        return { minAlphaDigit, maxAlphaDigit };
     }
 
-    int64_t getCalibrationValue2( const std::string& line )
+    // Scanning forwards for the first and backwards for the last match handles overlapping words like "eightwo".
+    int64_t getCalibrationValue2( std::string_view line )
     {
-        const auto firstDigit = std::ranges::find_if( line, [] ( char c )-> bool { return std::isdigit( c ); } );
-        const auto reversedLine = line | std::views::reverse;
-        const auto lastDigit = std::ranges::find_if( reversedLine, [] ( char c )-> bool { return std::isdigit( c ); } );
-        const auto [firstAlphaDigit, lastAlphaDigit] = findWrittenNumber( line );
+        std::optional<int64_t> first;
+        for( size_t position = 0; position < line.size() && !first; position++ )
+            first = getDigitAtFront( line.substr( position ) );
 
-        int64_t first = 0;
-        if( firstDigit != line.end() && std::distance( line.begin(), firstDigit ) < firstAlphaDigit.first )
-            first = toDigit( *firstDigit );
-        else
-            first = firstAlphaDigit.second;
+        std::optional<int64_t> last;
+        for( size_t position = line.size(); position > 0 && !last; position-- )
+            last = getDigitAtFront( line.substr( position - 1 ) );
 
-        int64_t last = 0;
-        if( lastDigit != reversedLine.end() && line.size() - std::distance( reversedLine.begin(), lastDigit ) > lastAlphaDigit.first )
-            last = toDigit( *lastDigit );
-        else
-            last = lastAlphaDigit.second;
-
-        return first * 10 + last;
+        return first.value_or( 0 ) * 10 + last.value_or( 0 );
     }
 
-    int64_t getSumCalibrationValues2( const std::vector<std::string>& lines )
+    int64_t getSumCalibrationValues2( std::span<const std::string_view> lines )
     {
-        return std::accumulate( lines.begin(), lines.end(), 0ll, [] ( int64_t sum, auto& line ) { return sum + getCalibrationValue2( line ); } );
+        return parallelMapReduce( lines, 0ll, getCalibrationValue2 );
     }
 
-    int64_t getSumCalibrationValues( const std::vector<std::string>& lines )
+    int64_t getSumCalibrationValues( std::span<const std::string_view> lines )
     {
-        return std::accumulate( lines.begin(), lines.end(), 0ll, [] ( int64_t sum, auto& line ) { return sum + getCalibrationValue( line ); } );
+        return parallelMapReduce( lines, 0ll, getCalibrationValue );
     }
 }
 
-void executeDay1()
+DayResult solveDay1( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream input( "Input/Day1.txt" );
-    auto lines = Day1::loadInput( input );
-    fmt::print( "Day1: Sum of calibration values: {}\n", Day1::getSumCalibrationValues( lines ) );
-    fmt::print( "Day1: Sum of calibration values 2: {}\n", Day1::getSumCalibrationValues2( lines ) );
+    auto& lines = input.getLines();
+    onPhaseDone( Phase::Parse );
+
+    DayResult result;
+    result.part1 = Day1::getSumCalibrationValues( lines );
+    onPhaseDone( Phase::Part1 );
+    result.part2 = Day1::getSumCalibrationValues2( lines );
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
\ No newline at end of file
@@ -1,275 +1,320 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day10
 {
-    enum class ElementType
+    // the cells of the map are the directions their pipe connects to
+    enum Connection : uint8_t
     {
-        Start,
-        Vertical,
-        Horizontal,
-        NE_Bend,
-        NW_Bend,
-        SW_Bend,
-        SE_Bend,
-        Empty
+        North = 1,
+        South = 2,
+        East = 4,
+        West = 8
     };
 
-    using Map = std::vector<std::vector<ElementType>>;
+    uint8_t getOpposite( uint8_t direction )
+    {
+        return ( ( direction & ( North | East ) ) << 1 ) | ( ( direction & ( South | West ) ) >> 1 );
+    }
 
-    ElementType toElementType( char c )
+    uint8_t toConnections( char c )
     {
         switch( c )
         {
-            case 'S':
-                return ElementType::Start;
             case '|':
-                return ElementType::Vertical;
+                return North | South;
             case '-':
-                return ElementType::Horizontal;
+                return East | West;
             case 'L':
-                return ElementType::NE_Bend;
+                return North | East;
             case 'J':
-                return ElementType::NW_Bend;
-            case 'F':
-                return ElementType::SE_Bend;
+                return North | West;
             case '7':
-                return ElementType::SW_Bend;
+                return South | West;
+            case 'F':
+                return South | East;
             case '.':
-                return ElementType::Empty;
+            case 'S':
+                return 0;
         }
         throw std::runtime_error( "invalid element type" );
     }
 
-    Map parseInput( std::istream& stream )
-    {
-        Map map;
-        for( std::string line; std::getline( stream, line ); )
-            map.push_back( line | std::views::transform( &toElementType ) | std::ranges::to<std::vector>() );
-        return map;
-    }
-
     struct Vec2
     {
         int64_t x = 0;
         int64_t y = 0;
 
         auto operator<=>( const Vec2& rhs ) const = default;
+
+        Vec2 operator+( const Vec2& rhs ) const
+        {
+            return { x + rhs.x, y + rhs.y };
+        }
     };
 
-    Vec2 findStartPosition( const Map& map )
+    // indexed by the bit of the direction
+    constexpr std::array<Vec2, 4> directionSteps = { Vec2{ 0, -1 }, Vec2{ 0, 1 }, Vec2{ 1, 0 }, Vec2{ -1, 0 } };
+
+    // The input with a border of empty cells around it, row after row in one array, so tracing needs no bounds checks.
+    struct Map
     {
-        for( auto [y, row] : map | std::views::enumerate )
+        int64_t width = 0;
+        int64_t height = 0;
+        std::vector<uint8_t> cells;
+        Vec2 start;
+
+        int64_t getIndex( const Vec2& position ) const
         {
-            if( auto start = std::ranges::find( row, ElementType::Start ); start != row.end() )
-                return { std::distance( row.begin(), start ), y };
+            return position.y * width + position.x;
         }
-        throw std::runtime_error( "no start" );
-    }
 
-    enum class Direction
-    {
-        North,
-        South,
-        East,
-        West
+        uint8_t get( const Vec2& position ) const
+        {
+            return cells[ getIndex( position ) ];
+        }
     };
 
-    std::pair<Vec2, Direction> getStep( const Vec2& position, Direction direction )
+    Map parseInput( std::span<const std::string_view> lines )
     {
-        switch( direction )
+        if( lines.empty() )
+            throw std::runtime_error( "no start" );
+        const auto width = ssize( lines.front() ) + 2;
+        const auto height = ssize( lines ) + 2;
+        Map map{ width, height, std::vector<uint8_t>( width * height ), {} };
+        std::optional<Vec2> start;
+        for( int64_t y = 1; auto line : lines )
         {
-            case Direction::North:
-                return { { position.x, position.y - 1 }, Direction::North };
-            case Direction::South:
-                return { { position.x, position.y + 1 }, Direction::South };
-            case Direction::East:
-                return { { position.x + 1, position.y }, Direction::East };
-            case Direction::West:
-                return { { position.x - 1, position.y }, Direction::West };
+            if( ssize( line ) != map.width - 2 )
+                throw std::runtime_error( "rows differ in length" );
+            for( int64_t x = 1; char c : line )
+            {
+                if( c == 'S' )
+                    start = Vec2{ x, y };
+                map.cells[ y * map.width + x++ ] = toConnections( c );
+            }
+            y++;
         }
-        throw std::runtime_error( "invalid direction" );
-    }
-
-    std::pair<Vec2,Direction> getValidFirstStep( const Map& map, const Vec2& start )
-    {
-        if( auto top = map[ start.y - 1 ][ start.x ]; top == ElementType::Vertical || top == ElementType::SE_Bend || top == ElementType::SW_Bend )
-            return getStep( start, Direction::North );
-        if( auto bot = map[ start.y + 1 ][ start.x ]; bot == ElementType::Vertical || bot == ElementType::NE_Bend || bot == ElementType::NW_Bend )
-            return getStep( start, Direction::South );
-        if( auto left = map[ start.y ][ start.x - 1 ]; left == ElementType::Horizontal || left == ElementType::SE_Bend || left == ElementType::NE_Bend )
-            return getStep( start, Direction::West );
-        if( auto right = map[ start.y ][ start.x + 1 ]; right == ElementType::Horizontal || right == ElementType::SW_Bend || right == ElementType::NW_Bend )
-            return getStep( start, Direction::East );
+        if( !start )
+            throw std::runtime_error( "no start" );
 
-        throw std::runtime_error( "no valid start step" );
+        // the start connects to every neighbour that connects back to it
+        map.start = *start;
+        uint8_t startConnections = 0;
+        for( uint8_t direction : { North, South, East, West } )
+        {
+            if( map.get( map.start + directionSteps[ std::countr_zero( direction ) ] ) & getOpposite( direction ) )
+                startConnections |= direction;
+        }
+        if( startConnections == 0 )
+            throw std::runtime_error( "no valid start step" );
+        map.cells[ map.start.y * map.width + map.start.x ] = startConnections;
+        return map;
     }
 
-    std::pair<Vec2, Direction> getNextStep( const Map& map, const std::pair<Vec2, Direction>& current )
+    // Calls onCell( position, direction ) for every cell of the loop, beginning with the start. direction is the one
+    // the loop leaves the cell in.
+    void traceLoop( const Map& map, const auto& onCell )
     {
-        auto& [position, direction] = current;
-        switch( map[ position.y ][ position.x ] )
+        auto position = map.start;
+        auto direction = static_cast<uint8_t>( 1 << std::countr_zero( map.get( map.start ) ) );
+        do
         {
-            case Day10::ElementType::Vertical:
-            case Day10::ElementType::Horizontal:
-                return getStep( position, direction );
-            case Day10::ElementType::NE_Bend:
-                if( direction == Direction::South )
-                    return getStep( position, Direction::East );
-                else
-                    return getStep( position, Direction::North );
-            case Day10::ElementType::NW_Bend:
-                if( direction == Direction::South )
-                    return getStep( position, Direction::West );
-                else
-                    return getStep( position, Direction::North );
-            case Day10::ElementType::SW_Bend:
-                if( direction == Direction::North )
-                    return getStep( position, Direction::West );
-                else
-                    return getStep( position, Direction::South );
-            case Day10::ElementType::SE_Bend:
-                if( direction == Direction::North )
-                    return getStep( position, Direction::East );
-                else
-                    return getStep( position, Direction::South );
-        }
-        throw std::runtime_error( "invalid element" );
+            onCell( position, direction );
+            position = position + directionSteps[ std::countr_zero( direction ) ];
+            const auto cell = map.get( position );
+            if( !( cell & getOpposite( direction ) ) )
+                throw std::runtime_error( "invalid element" );
+            direction = static_cast<uint8_t>( cell & ~getOpposite( direction ) );
+        } while( position != map.start );
     }
 
     int64_t getLoopLength( const Map& map )
     {
-        const auto start = findStartPosition( map );
-        auto currentPosition = getValidFirstStep( map, start );
-        int64_t numberOfSteps = 1;
-        for( ;currentPosition.first != start; numberOfSteps++ )
-            currentPosition = getNextStep( map, currentPosition );
-        return numberOfSteps;
+        int64_t loopLength = 0;
+        traceLoop( map, [ & ] ( const Vec2&, uint8_t ) { loopLength++; } );
+        return loopLength;
     }
 
-    std::map<Vec2,ElementType> getLoopPositions( const Map& map )
+    // The shoelace formula gives the area of the loop polygon and Pick's theorem turns it into the number of cells strictly
+    // inside the loop, so only the loop is traced and nothing is stored.
+    int64_t getNumberEnclosed( const Map& map )
     {
-        std::map<Vec2, ElementType> loopPositions;
-        const auto start = findStartPosition( map );
-        auto currentPosition = getValidFirstStep( map, start );
-        loopPositions.emplace( start, ElementType::Start );
-        while( currentPosition.first != start )
-        {
-            loopPositions.emplace( currentPosition.first, map[ currentPosition.first.y ][ currentPosition.first.x ] );
-            currentPosition = getNextStep( map, currentPosition );
-        }
-        return loopPositions;
+        int64_t doubleArea = 0;
+        int64_t loopLength = 0;
+        auto previous = map.start;
+        traceLoop( map, [ & ] ( const Vec2& position, uint8_t ) {
+            doubleArea += previous.x * position.y - position.x * previous.y;
+            previous = position;
+            loopLength++;
+            } );
+        doubleArea += previous.x * map.start.y - map.start.x * previous.y;
+        return ( std::abs( doubleArea ) - loopLength ) / 2 + 1;
     }
 
-    using FillMap = std::vector<std::vector<bool>>;
+    struct Region
+    {
+        int64_t size = 0;
+        bool isInside = false; // enclosed by the main loop
+    };
 
-    void addElementToFillMap( FillMap& map, const Vec2& position, ElementType type )
+    // The regions are the 4-connected areas of empty cells between the pipes, ordered by their first cell. The rows are
+    // split into bands that build their own union-find in parallel, the band borders are merged afterwards.
+    std::vector<Region> getRegions( const Map& map )
     {
-        switch( type )
+        constexpr uint32_t noCell = std::numeric_limits<uint32_t>::max();
+        constexpr uint32_t regionMarker = 1u << 31;
+        if( map.cells.size() >= regionMarker )
+            throw std::runtime_error( "map is too large" );
+
+        // loop cells that connect to the north, a ray from the left border changes sides of the loop at them
+        std::vector<bool> crossings( map.cells.size() );
+        traceLoop( map, [ & ] ( const Vec2& position, uint8_t direction ) {
+            if( direction == North )
+                crossings[ map.getIndex( position ) ] = true;
+            else if( direction == South )
+                crossings[ map.getIndex( position + directionSteps[ std::countr_zero( direction ) ] ) ] = true;
+            } );
+
+        // every tree only links to smaller cells, so a root is the first cell of its region
+        std::vector<uint32_t> parents( map.cells.size(), noCell );
+        auto find = [ & ] ( uint32_t cell ) {
+            while( parents[ cell ] != cell )
+                cell = parents[ cell ] = parents[ parents[ cell ] ];
+            return cell;
+            };
+        auto unite = [ & ] ( uint32_t lhs, uint32_t rhs ) {
+            lhs = find( lhs );
+            rhs = find( rhs );
+            parents[ std::max( lhs, rhs ) ] = std::min( lhs, rhs );
+            };
+        auto isEmpty = [ & ] ( uint32_t cell ) { return map.cells[ cell ] == 0; };
+
+        const auto numRows = map.height - 2;
+        const auto numBands = std::clamp<int64_t>( ThreadPool::getInstance().getNumThreads() * 4, 1, numRows );
+        auto getBandStart = [ & ] ( int64_t band ) { return 1 + numRows * band / numBands; };
+
+        // the bands only link cells inside of them, so they don't share any parents
+        parallelFor( numBands, [ & ] ( size_t band ) {
+            for( auto y = getBandStart( band ); y < getBandStart( band + 1 ); y++ )
+            {
+                for( int64_t x = 1; x < map.width - 1; x++ )
+                {
+                    const auto cell = static_cast<uint32_t>( y * map.width + x );
+                    if( !isEmpty( cell ) )
+                        continue;
+                    parents[ cell ] = cell;
+                    if( x > 1 && isEmpty( cell - 1 ) )
+                        unite( cell, cell - 1 );
+                    if( y > getBandStart( band ) && isEmpty( cell - map.width ) )
+                        unite( cell, cell - static_cast<uint32_t>( map.width ) );
+                }
+            }
+            } );
+        for( int64_t band = 1; band < numBands; band++ )
         {
-            case Day10::ElementType::Start:
-                for( size_t y = position.y * 3; y < position.y * 3 + 3; y++ )
-                    for( size_t x = position.x * 3; x < position.x * 3 + 3; x++ )
-                        map[ y ][ x ] = true;
-                break;
-            case Day10::ElementType::Vertical:
-                for( size_t y = position.y * 3; y < position.y * 3 + 3; y++ )
-                    map[ y ][ position.x * 3 + 1 ] = true;
-                break;
-            case Day10::ElementType::Horizontal:
-                for( size_t x = position.x * 3; x < position.x * 3 + 3; x++ )
-                    map[ position.y * 3 + 1 ][ x ] = true;
-                break;
-            case Day10::ElementType::NE_Bend:
-                map[ position.y * 3 + 0 ][ position.x * 3 + 1 ] = true;
-                map[ position.y * 3 + 1 ][ position.x * 3 + 1 ] = true;
-                map[ position.y * 3 + 1 ][ position.x * 3 + 2 ] = true;
-                break;
-            case Day10::ElementType::NW_Bend:
-                map[ position.y * 3 + 0 ][ position.x * 3 + 1 ] = true;
-                map[ position.y * 3 + 1 ][ position.x * 3 + 0 ] = true;
-                map[ position.y * 3 + 1 ][ position.x * 3 + 1 ] = true;
-                break;
-            case Day10::ElementType::SW_Bend:
-                map[ position.y * 3 + 1 ][ position.x * 3 + 0 ] = true;
-                map[ position.y * 3 + 1 ][ position.x * 3 + 1 ] = true;
-                map[ position.y * 3 + 2 ][ position.x * 3 + 1 ] = true;
-                break;
-            case Day10::ElementType::SE_Bend:
-                map[ position.y * 3 + 1 ][ position.x * 3 + 1 ] = true;
-                map[ position.y * 3 + 1 ][ position.x * 3 + 2 ] = true;
-                map[ position.y * 3 + 2 ][ position.x * 3 + 1 ] = true;
-                break;
+            for( int64_t x = 1; x < map.width - 1; x++ )
+            {
+                const auto cell = static_cast<uint32_t>( getBandStart( band ) * map.width + x );
+                if( isEmpty( cell ) && isEmpty( cell - map.width ) )
+                    unite( cell, cell - static_cast<uint32_t>( map.width ) );
+            }
         }
-    }
 
-    FillMap getFillMap( const Map& map )
-    {
-        FillMap fillMap( map.size() * 3 );
-        const auto rowLength = map.front().size() * 3;
-        for( auto& row : fillMap )
-            row.resize( rowLength );
+        // roots are numbered in order of their first cell, then every root holds its marked region index
+        auto forEachEmptyCell = [ & ] ( size_t band, const auto& onCell ) {
+            for( auto y = getBandStart( band ); y < getBandStart( band + 1 ); y++ )
+            {
+                bool isInside = false;
+                for( int64_t x = 1; x < map.width - 1; x++ )
+                {
+                    const auto cell = static_cast<uint32_t>( y * map.width + x );
+                    if( crossings[ cell ] )
+                        isInside = !isInside;
+                    if( isEmpty( cell ) )
+                        onCell( cell, isInside );
+                }
+            }
+            };
+        std::vector<uint32_t> firstRegions( numBands + 1 );
+        parallelFor( numBands, [ & ] ( size_t band ) {
+            forEachEmptyCell( band, [ & ] ( uint32_t cell, bool ) { firstRegions[ band + 1 ] += parents[ cell ] == cell; } );
+            } );
+        std::partial_sum( firstRegions.begin(), firstRegions.end(), firstRegions.begin() );
 
-        for( auto& [position, type] : getLoopPositions( map ) )
-            addElementToFillMap( fillMap, position, type );
+        std::vector<Region> regions( firstRegions.back() );
+        parallelFor( numBands, [ & ] ( size_t band ) {
+            auto region = firstRegions[ band ];
+            forEachEmptyCell( band, [ & ] ( uint32_t cell, bool isInside ) {
+                if( parents[ cell ] != cell )
+                    return;
+                regions[ region ].isInside = isInside;
+                parents[ cell ] = regionMarker | region++;
+                } );
+            } );
 
-        return fillMap;
+        // regions can span bands, so the sizes are added up atomically, once per run of cells with the same region
+        std::vector<std::atomic<int64_t>> sizes( regions.size() );
+        parallelFor( numBands, [ & ] ( size_t band ) {
+            auto lastRegion = noCell;
+            int64_t runLength = 0;
+            forEachEmptyCell( band, [ & ] ( uint32_t cell, bool ) {
+                while( !( parents[ cell ] & regionMarker ) )
+                    cell = parents[ cell ];
+                if( const auto region = parents[ cell ] & ~regionMarker; region != lastRegion )
+                {
+                    if( runLength > 0 )
+                        sizes[ lastRegion ].fetch_add( runLength, std::memory_order_relaxed );
+                    lastRegion = region;
+                    runLength = 0;
+                }
+                runLength++;
+                } );
+            if( runLength > 0 )
+                sizes[ lastRegion ].fetch_add( runLength, std::memory_order_relaxed );
+            } );
+        for( size_t region = 0; region < regions.size(); region++ )
+            regions[ region ].size = sizes[ region ].load();
+        return regions;
     }
+}
 
-    void floodFill( FillMap& map )
+namespace Day10
+{
+    DayResult solve( const InputFile& input, const PhaseCallback& onPhaseDone, bool withDetails )
     {
-        std::vector<Vec2> positions{ Vec2{ 0,0 } };
-        while( !positions.empty() )
-        {
-            auto position = positions.back();
-            positions.pop_back();
-            if( map[ position.y ][ position.x ] )
-                continue;
+        auto map = parseInput( input.getLines() );
+        onPhaseDone( Phase::Parse );
 
-            map[ position.y ][ position.x ] = true;
-            if( position.x > 0  )
-                positions.push_back( { position.x - 1, position.y } );
-            if( position.x < map.front().size() - 1 )
-                positions.push_back( { position.x + 1, position.y } );
-            if( position.y > 0 )
-                positions.push_back( { position.x, position.y - 1 } );
-            if( position.y < map.size() - 1 )
-                positions.push_back( { position.x, position.y + 1 } );
-        }
-    }
+        DayResult result;
+        result.part1 = getLoopLength( map ) / 2;
+        onPhaseDone( Phase::Part1 );
+        result.part2 = getNumberEnclosed( map );
+        onPhaseDone( Phase::Part2 );
+        if( !withDetails )
+            return result;
 
-    bool isFilled( const FillMap& map, const Vec2& position )
-    {
-        for( size_t y = 0; y < 3; y++ )
+        // the regions need another 4 bytes per cell, failing to label them must not lose the answers
+        try
         {
-            for( size_t x = 0; x < 3; x++ )
-                if( map[ position.y + y ][ position.x + x ] )
-                    return true;
+            const auto regions = getRegions( map );
+            result.details = fmt::format( "{} empty regions, {} inside the loop", regions.size(), std::ranges::count_if( regions, &Region::isInside ) );
         }
-        return false;
-    }
-
-    int64_t getNumFilled( const FillMap& map )
-    {
-        int64_t numFilled = 0;
-        for( int64_t y = 0; y < ssize( map ); y+=3 )
-            for( int64_t x = 0; x < ssize( map[ y ] ); x += 3 )
-                numFilled += isFilled( map, { x, y } );
-        return numFilled;
+        catch( const std::exception& exception )
+        {
+            result.details = fmt::format( "no regions: {}", exception.what() );
+        }
+        onPhaseDone( Phase::Details );
+        return result;
     }
+}
 
-    int64_t getNumberEnclosed( const Map& map )
-    {
-        auto fillMap = getFillMap( map );
-        floodFill( fillMap );
-
-        return map.size() * map.front().size() - getNumFilled( fillMap );
-    }
+DayResult solveDay10( const InputFile& input, const PhaseCallback& onPhaseDone )
+{
+    return Day10::solve( input, onPhaseDone, false );
 }
 
-void executeDay10()
+DayResult solveDay10WithDetails( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/Day10.txt" );
-    auto map = Day10::parseInput( file );
-    fmt::print( "Intersection distance: {}\n", Day10::getLoopLength( map ) / 2 );
-    fmt::print( "Number of enclosed cells: {}\n", Day10::getNumberEnclosed( map ) );
+    return Day10::solve( input, onPhaseDone, true );
 }
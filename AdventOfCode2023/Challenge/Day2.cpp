@@ -1,4 +1,5 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day2
 {
@@ -8,95 +9,102 @@ namespace Day2
         int64_t numGreenCubes = 0;
         int64_t numBlueCubes = 0;
     };
-    struct Game
+
+    // Both parts only depend on the most cubes of each color shown in any pass of a game, so the games are reduced to these
+    // while parsing and stored column by column.
+    struct Games
     {
-        int64_t id = 0;
-        std::vector<GamePass> passes;
+        std::vector<int64_t> ids;
+        std::vector<int64_t> maxRedCubes;
+        std::vector<int64_t> maxGreenCubes;
+        std::vector<int64_t> maxBlueCubes;
+
+        size_t size() const
+        {
+            return ids.size();
+        }
     };
 
-    GamePass parseGamePass( auto gamePassString )
+    GamePass parseGamePass( std::string_view gamePassString )
     {
         GamePass gamePass;
         for( auto game : gamePassString | std::views::split( ',' ) )
         {
-            auto cubes = std::string_view{ game } | std::views::split( ' ' ) | std::views::drop_while( [] ( auto view ) { return view.begin() == view.end(); } );
-            auto numCubes = std::stoll( std::string( std::string_view{ *cubes.begin() } ) );
-            auto cubeColor = std::string_view{ *std::next( cubes.begin() ) };
+            Scanner scanner( std::string_view{ game } );
+            scanner.skipSpaces();
+            const auto numCubes = scanner.readUnsigned();
+            if( !numCubes || !scanner.skipSpaces() )
+                throw std::runtime_error( "invalide line" );
+            const auto cubeColor = scanner.readWord();
             if( cubeColor == "red" )
-                gamePass.numRedCubes = numCubes;
+                gamePass.numRedCubes = *numCubes;
             else if( cubeColor == "green" )
-                gamePass.numGreenCubes = numCubes;
+                gamePass.numGreenCubes = *numCubes;
             else if( cubeColor == "blue" )
-                gamePass.numBlueCubes = numCubes;
+                gamePass.numBlueCubes = *numCubes;
         }
         return gamePass;
     }
 
-    Game parseGame( const std::string& line )
+    void addGame( Games& games, std::string_view line )
     {
-        static std::regex gameIdRegex( R"(Game (\d+): (.*))" );
-        std::smatch match;
-        if( !std::regex_match( line, match, gameIdRegex ) )
+        Scanner scanner( line );
+        const auto id = scanner.expect( "Game " ) ? scanner.readUnsigned() : std::nullopt;
+        if( !id || !scanner.expect( ": " ) )
             throw std::runtime_error( "invalide line" );
 
-        Game game{ std::stoll( match[ 1 ] ) };
-
-        auto games = match[ 2 ].str();
-        for( auto gamePass : games | std::views::split( ';' ) )
-            game.passes.push_back( parseGamePass( gamePass ) );
+        GamePass maxCubes;
+        for( auto gamePassString : scanner.getRemaining() | std::views::split( ';' ) )
+        {
+            const auto gamePass = parseGamePass( std::string_view{ gamePassString } );
+            maxCubes.numRedCubes = std::max( maxCubes.numRedCubes, gamePass.numRedCubes );
+            maxCubes.numGreenCubes = std::max( maxCubes.numGreenCubes, gamePass.numGreenCubes );
+            maxCubes.numBlueCubes = std::max( maxCubes.numBlueCubes, gamePass.numBlueCubes );
+        }
 
-        return game;
+        games.ids.push_back( *id );
+        games.maxRedCubes.push_back( maxCubes.numRedCubes );
+        games.maxGreenCubes.push_back( maxCubes.numGreenCubes );
+        games.maxBlueCubes.push_back( maxCubes.numBlueCubes );
     }
 
-    std::vector<Game> parseInput( std::istream& stream )
+    Games parseInput( std::span<const std::string_view> lines )
     {
-        std::vector<Game> games;
-        for( std::string line; std::getline( stream, line ); )
-            games.push_back( parseGame( line ) );
+        Games games;
+        for( auto columns : { &games.ids, &games.maxRedCubes, &games.maxGreenCubes, &games.maxBlueCubes } )
+            columns->reserve( lines.size() );
+        for( auto line : lines )
+            addGame( games, line );
         return games;
     }
 
-    bool isGamePassValid( const GamePass& gamePass )
+    int64_t getSumOfValidGames( const Games& games )
     {
         constexpr int64_t numRedCubes = 12, numGreenCubes = 13, numBlueCubes = 14;
 
-        return gamePass.numRedCubes <= numRedCubes && gamePass.numGreenCubes <= numGreenCubes && gamePass.numBlueCubes <= numBlueCubes;
-    }
-
-    bool isGameValid( const Game& game )
-    {
-        return std::ranges::all_of( game.passes, &isGamePassValid );
-    }
-
-    int64_t getSumOfValidGames( const std::vector<Game>& games )
-    {
-        return std::accumulate( games.begin(), games.end(), 0ll, [] ( int64_t sum, const Game& game ) { return isGameValid( game ) ? sum + game.id : sum; } );
-    }
-
-    int64_t getPowerOfGame( const Game& game )
-    {
-        int64_t minRedCubes = 0, minGreenCubes = 0, minBlueCubes = 0;
-
-        for( auto& gamePass : game.passes )
-        {
-            minRedCubes = std::max( minRedCubes, gamePass.numRedCubes );
-            minGreenCubes = std::max( minGreenCubes, gamePass.numGreenCubes );
-            minBlueCubes = std::max( minBlueCubes, gamePass.numBlueCubes );
-        }
-
-        return minRedCubes * minGreenCubes * minBlueCubes;
+        return parallelMapReduce( std::views::iota( size_t{ 0 }, games.size() ), 0ll, [ & ] ( size_t game ) {
+            const bool isValid = games.maxRedCubes[ game ] <= numRedCubes && games.maxGreenCubes[ game ] <= numGreenCubes && games.maxBlueCubes[ game ] <= numBlueCubes;
+            return isValid ? games.ids[ game ] : 0;
+            } );
     }
 
-    int64_t getSumOfPowerOfGames( const std::vector<Game>& games )
+    int64_t getSumOfPowerOfGames( const Games& games )
     {
-        return std::accumulate( games.begin(), games.end(), 0ll, [] ( int64_t sum, const Game& game ) { return getPowerOfGame( game ) + sum; } );
+        return parallelMapReduce( std::views::iota( size_t{ 0 }, games.size() ), 0ll, [ & ] ( size_t game ) {
+            return games.maxRedCubes[ game ] * games.maxGreenCubes[ game ] * games.maxBlueCubes[ game ];
+            } );
     }
 }
 
-void executeDay2()
+DayResult solveDay2( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/Day2.txt" );
-    auto games = Day2::parseInput( file );
-    fmt::print( "Sum of valid game ids: {}\n", getSumOfValidGames( games ) );
-    fmt::print( "Sum of power of games: {}\n", getSumOfPowerOfGames( games ) );
+    auto games = Day2::parseInput( input.getLines() );
+    onPhaseDone( Phase::Parse );
+
+    DayResult result;
+    result.part1 = Day2::getSumOfValidGames( games );
+    onPhaseDone( Phase::Part1 );
+    result.part2 = Day2::getSumOfPowerOfGames( games );
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
@@ -1,124 +1,144 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day3
 {
-    std::vector<std::string> loadInput( std::istream& stream )
+    bool isDigit( char c )
     {
-        std::vector<std::string> data;
-        for( std::string line; std::getline( stream, line ); )
-            data.push_back( std::move( line ) );
-        return data;
+        return c >= '0' && c <= '9';
     }
 
-    struct Vec2
+    enum CellFlags : uint8_t
     {
-        int64_t x = 0;
-        int64_t y = 0;
-        auto operator<=>( const Vec2& ) const = default;
+        Symbol = 1,
+        Gear = 2
     };
 
-    std::map<Vec2, char> getSymbolPositions( const std::vector<std::string>& data )
+    // CellFlags of the whole schematic, padded by one empty cell on every side so that neighbours never need bounds checks.
+    struct SymbolMap
     {
-        std::map<Vec2, char> symbols;
-        for( int64_t y = 0; y < data.size(); y++ )
+        int64_t width = 0;
+        std::vector<uint8_t> cells;
+
+        uint8_t get( int64_t x, int64_t y ) const
         {
-            for( int64_t x = 0; x < data[ y ].size(); x++ )
+            return cells[ ( y + 1 ) * width + x + 1 ];
+        }
+    };
+
+    SymbolMap getSymbolMap( std::span<const std::string_view> data )
+    {
+        int64_t maxLength = 0;
+        for( auto row : data )
+            maxLength = std::max<int64_t>( maxLength, ssize( row ) );
+        const auto width = maxLength + 2;
+        SymbolMap symbols{ width, std::vector<uint8_t>( width * ( data.size() + 2 ) ) };
+        for( int64_t y = 0; y < ssize( data ); y++ )
+        {
+            for( int64_t x = 0; x < ssize( data[ y ] ); x++ )
             {
                 char c = data[ y ][ x ];
-                if( !std::isdigit( c ) && c != '.' )
-                    symbols.emplace( Vec2{ x,y }, c );
+                if( !isDigit( c ) && c != '.' )
+                    symbols.cells[ ( y + 1 ) * width + x + 1 ] = c == '*' ? Symbol | Gear : Symbol;
             }
         }
         return symbols;
     }
 
-    bool isNumberNearSymbol( const Vec2& position, int64_t length, const std::map<Vec2, char>& symbols )
+    // Calls callback( value, x, length ) for every number in the row.
+    void forEachNumber( std::string_view row, auto callback )
     {
-        if( symbols.count( Vec2{ position.x - 1, position.y } ) || symbols.count( Vec2{ position.x + length, position.y } ) )
-            return true;
-        for( auto y : { position.y - 1, position.y + 1 } )
+        for( int64_t x = 0; x < ssize( row ); x++ )
         {
-            for( int64_t x = position.x - 1; x < position.x + length + 1; x++ )
-            {
-                if( symbols.count( Vec2{ x, y } ) )
-                    return true;
-            }
+            if( !isDigit( row[ x ] ) )
+                continue;
+            const auto start = x;
+            int64_t value = 0;
+            for( ; x < ssize( row ) && isDigit( row[ x ] ); x++ )
+                value = value * 10 + ( row[ x ] - '0' );
+            callback( value, start, x - start );
         }
-        return false;
     }
 
-    void forEachNumber( const std::vector<std::string>& data, auto callback )
+    // Calls callback( x, y ) for every cell of the box around a number, including the number itself.
+    void forEachTestPosition( int64_t x, int64_t y, int64_t length, auto callback )
     {
-        for( int64_t y = 0; y < data.size(); y++ )
-        {
-            auto searchStart = data[ y ].begin();
-            auto findStart = [ & ] {
-                return std::find_if( searchStart, data[ y ].end(), [] ( char c ) { return std::isdigit( c ); } );
-                };
-
-            for( auto startNumber = findStart(); startNumber != data[ y ].end(); startNumber = findStart() )
-            {
-                auto endNumber = std::find_if( startNumber, data[ y ].end(), [] ( char c ) { return !std::isdigit( c ); } );
-                auto value = std::stoll( std::string( startNumber, endNumber ) );
-                auto position = Vec2{ std::distance( data[ y ].begin(), startNumber ), y };
-                auto length = endNumber - startNumber;
-                callback( value, position, length );
-                searchStart = endNumber;
-            }
-        }
+        for( int64_t testY = y - 1; testY <= y + 1; testY++ )
+            for( int64_t testX = x - 1; testX <= x + length; testX++ )
+                callback( testX, testY );
     }
 
-    int64_t getSumOfParts( const std::vector<std::string>& data, const std::map<Vec2, char>& symbols )
+    bool isNumberNearSymbol( int64_t x, int64_t y, int64_t length, const SymbolMap& symbols )
     {
-        int64_t sumParts = 0;
-        forEachNumber( data, [&] ( auto value, auto position, auto length ) {
-            if( isNumberNearSymbol( position, length, symbols ) )
-                sumParts += value;
-            } );
-        return sumParts;
+        bool isNearSymbol = false;
+        forEachTestPosition( x, y, length, [ & ] ( int64_t testX, int64_t testY ) { isNearSymbol |= ( symbols.get( testX, testY ) & Symbol ) != 0; } );
+        return isNearSymbol;
     }
 
-    void forEachTestPosition( const Vec2& position, int64_t length, auto callback )
+    int64_t getSumOfParts( std::span<const std::string_view> data, const SymbolMap& symbols )
     {
-        callback( Vec2{ position.x - 1, position.y } );
-        callback( Vec2{ position.x + length, position.y } );
-        for( auto y : { position.y - 1, position.y + 1 } )
+        int64_t sumParts = 0;
+        for( int64_t y = 0; y < ssize( data ); y++ )
         {
-            for( int64_t x = position.x - 1; x < position.x + length + 1; x++ )
-                callback( Vec2{ x,y } );
+            forEachNumber( data[ y ], [ & ] ( int64_t value, int64_t x, int64_t length ) {
+                if( isNumberNearSymbol( x, y, length, symbols ) )
+                    sumParts += value;
+                } );
         }
+        return sumParts;
     }
 
-    void addGears( std::map<Vec2, std::vector<int64_t>>& gears, const Vec2& position, int64_t length, int64_t partValue, const std::map<Vec2, char>& symbols )
+    struct GearSlot
     {
-        forEachTestPosition( position, length, [ & ] ( const auto& testPosition ) {
-            if( auto symbol = symbols.find( testPosition ); symbol != symbols.end() && symbol->second == '*' )
-                gears[ testPosition ].push_back( partValue );
-        } );
-    }
+        int64_t count = 0;
+        int64_t product = 1;
+    };
 
-    std::map<Vec2, std::vector<int64_t>> getGears( const std::vector<std::string>& data, const std::map<Vec2, char>& symbols )
+    int64_t getSumGearRatios( std::span<const std::string_view> data, const SymbolMap& symbols )
     {
-        std::map<Vec2, std::vector<int64_t>> gears;
-        forEachNumber( data, [ & ] ( auto value, auto position, auto length ) {
-            addGears( gears, position, length, value, symbols );
-            } );
-        std::erase_if( gears, [] ( auto& gear ) { return gear.second.size() != 2; } );
-        return gears;
-    }
+        // numbers of row y only reach gears on rows y - 1 to y + 1, so three rows of slots are enough
+        std::vector<GearSlot> slots( 3 * symbols.width );
+        auto getSlot = [ & ] ( int64_t x, int64_t y ) -> GearSlot& { return slots[ ( ( y + 3 ) % 3 ) * symbols.width + x + 1 ]; };
 
-    int64_t getSumGearRatios( const std::vector<std::string>& data, const std::map<Vec2, char>& symbols )
-    {
-        auto gears = getGears( data, symbols );
-        return std::accumulate( gears.begin(), gears.end(), 0ll, [] ( int64_t sum, auto& gear ) { return sum + gear.second[ 0 ] * gear.second[ 1 ]; } );
+        int64_t sumGearRatios = 0;
+        auto finishRow = [ & ] ( int64_t y ) {
+            for( int64_t x = -1; x < symbols.width - 1; x++ )
+            {
+                auto& slot = getSlot( x, y );
+                if( slot.count == 2 )
+                    sumGearRatios += slot.product;
+                slot = {};
+            }
+            };
+
+        for( int64_t y = 0; y < ssize( data ); y++ )
+        {
+            forEachNumber( data[ y ], [ & ] ( int64_t value, int64_t x, int64_t length ) {
+                forEachTestPosition( x, y, length, [ & ] ( int64_t testX, int64_t testY ) {
+                    if( !( symbols.get( testX, testY ) & Gear ) )
+                        return;
+                    auto& slot = getSlot( testX, testY );
+                    if( ++slot.count <= 2 )
+                        slot.product *= value;
+                    } );
+                } );
+            finishRow( y - 1 );
+        }
+        finishRow( ssize( data ) - 1 );
+        return sumGearRatios;
     }
 }
 
-void executeDay3()
+DayResult solveDay3( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/Day3.txt" );
-    auto data = Day3::loadInput( file );
-    auto symbols = Day3::getSymbolPositions( data );
-    fmt::print( "Sum of valid parts: {}\n", Day3::getSumOfParts( data, symbols ) );
-    fmt::print( "Sum of gear ratios: {}\n", Day3::getSumGearRatios( data, symbols ) );
+    auto& data = input.getLines();
+    auto symbols = Day3::getSymbolMap( data );
+    onPhaseDone( Phase::Parse );
+
+    DayResult result;
+    result.part1 = Day3::getSumOfParts( data, symbols );
+    onPhaseDone( Phase::Part1 );
+    result.part2 = Day3::getSumGearRatios( data, symbols );
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
@@ -1,52 +1,95 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day4
 {
+    // Card numbers are small, so sets of them are bitsets; anything out of range goes to a sorted fallback list.
+    struct NumberSet
+    {
+        static constexpr int64_t maxBitsetNumber = 128;
+        std::bitset<maxBitsetNumber> bits;
+        std::vector<int64_t> largeNumbers;
+    };
+
     struct Card
     {
         int64_t id = 0;
-        std::set<int64_t> winningNumbers;
-        std::set<int64_t> gameNumbers;
+        NumberSet winningNumbers;
+        NumberSet gameNumbers;
+        int64_t numMatchingNumbers = 0;
     };
 
-    auto toNumbersSet( const auto& match )
+    NumberSet toNumberSet( std::string_view numbers )
+    {
+        NumberSet numberSet;
+        for( Scanner scanner( numbers ); scanner.skipSpaces(), !scanner.atEnd(); )
+        {
+            const auto number = scanner.readUnsigned();
+            if( !number )
+                throw std::runtime_error( "invalid input" );
+            if( *number < NumberSet::maxBitsetNumber )
+                numberSet.bits.set( *number );
+            else
+                numberSet.largeNumbers.push_back( *number );
+        }
+        std::ranges::sort( numberSet.largeNumbers );
+        const auto duplicates = std::ranges::unique( numberSet.largeNumbers );
+        numberSet.largeNumbers.erase( duplicates.begin(), duplicates.end() );
+        return numberSet;
+    }
+
+    int64_t getNumMatchingNumbers( const NumberSet& lhs, const NumberSet& rhs )
     {
-        return std::string_view{ match.first, match.second }
-            | std::views::split( ' ' )
-            | std::views::filter( [] ( auto range ) { return !std::ranges::empty( range ); } )
-            | std::views::transform( [] ( auto range ) { return std::stoll( std::string{ range.begin(), range.end() } ); } )
-            | std::ranges::to<std::set>();
+        int64_t numMatching = ( lhs.bits & rhs.bits ).count();
+        if( lhs.largeNumbers.empty() || rhs.largeNumbers.empty() )
+            return numMatching;
+        for( auto left = lhs.largeNumbers.begin(), right = rhs.largeNumbers.begin(); left != lhs.largeNumbers.end() && right != rhs.largeNumbers.end(); )
+        {
+            if( *left < *right )
+                left++;
+            else if( *right < *left )
+                right++;
+            else
+            {
+                numMatching++;
+                left++;
+                right++;
+            }
+        }
+        return numMatching;
     }
 
-    Card parseCard( const std::string& line )
+    Card parseCard( std::string_view line )
     {
-        static std::regex regex( R"(Card\s+(\d+): (.*) \| (.*))" );
-        std::smatch match;
-        if( !std::regex_match( line, match, regex ) )
+        Scanner scanner( line );
+        const auto id = scanner.expect( "Card" ) && scanner.skipSpaces() ? scanner.readUnsigned() : std::nullopt;
+        if( !id || !scanner.expect( ": " ) )
             throw std::runtime_error( "invalid input" );
 
-        return { std::stoll( match[ 1 ] ), toNumbersSet( match[ 2 ] ), toNumbersSet( match[ 3 ] ) };
+        const auto numbers = scanner.getRemaining();
+        const auto separator = numbers.rfind( " | " );
+        if( separator == std::string_view::npos )
+            throw std::runtime_error( "invalid input" );
+
+        Card card{ *id, toNumberSet( numbers.substr( 0, separator ) ), toNumberSet( numbers.substr( separator + 3 ) ) };
+        card.numMatchingNumbers = getNumMatchingNumbers( card.winningNumbers, card.gameNumbers );
+        return card;
     }
 
-    std::vector<Card> parseInput( std::istream& file )
+    std::vector<Card> parseInput( std::span<const std::string_view> lines )
     {
         std::vector<Card> cards;
+        cards.reserve( lines.size() );
 
-        for( std::string line; std::getline( file, line ); )
+        for( auto line : lines )
             cards.push_back( parseCard( line ) );
 
         return cards;
     }
 
-    int64_t getNumMatchingNumbers( const Card& card )
-    {
-        std::vector<int64_t> winningNumbers;
-        std::ranges::set_intersection( card.winningNumbers, card.gameNumbers, back_inserter( winningNumbers ) );
-        return winningNumbers.size();
-    }
     int64_t getCardPoints( const Card& card )
     {
-        const auto numWinningNumbers = getNumMatchingNumbers( card );
+        const auto numWinningNumbers = card.numMatchingNumbers;
         if( numWinningNumbers == 0 )
             return 0;
         return 1ll << ( numWinningNumbers - 1ll );
@@ -54,12 +97,12 @@ namespace Day4
 
     int64_t getTotalPoints( const std::vector<Card>& cards )
     {
-        return std::accumulate( cards.begin(), cards.end(), 0ll, [] ( int64_t sum, auto& card ) { return sum + getCardPoints( card ); } );
+        return parallelMapReduce( cards, 0ll, getCardPoints );
     }
 
     void handleCard( const Card& card, std::vector<int64_t>& numberOfCards )
     {
-        const auto numWinningNumbers = getNumMatchingNumbers( card );
+        const auto numWinningNumbers = card.numMatchingNumbers;
         for( int64_t cardId = card.id; cardId < card.id + numWinningNumbers; cardId++ )
             numberOfCards[ cardId ]+= numberOfCards[card.id-1];
     }
@@ -73,10 +116,15 @@ namespace Day4
     }
 }
 
-void executeDay4()
+DayResult solveDay4( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/Day4.txt" );
-    auto cards = Day4::parseInput( file );
-    fmt::print( "Total points: {}\n", Day4::getTotalPoints( cards ) );
-    fmt::print( "Total number of cards: {}\n", Day4::getTotalNumberOfCards( cards ) );
+    auto cards = Day4::parseInput( input.getLines() );
+    onPhaseDone( Phase::Parse );
+
+    DayResult result;
+    result.part1 = Day4::getTotalPoints( cards );
+    onPhaseDone( Phase::Part1 );
+    result.part2 = Day4::getTotalNumberOfCards( cards );
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
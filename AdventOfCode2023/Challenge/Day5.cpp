@@ -1,4 +1,5 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day5
 {
@@ -7,6 +8,41 @@ namespace Day5
         int64_t start;
         int64_t length;
     };
+
+    // Sorted ranges where overlapping and touching ranges are merged, so mapping a set never multiplies fragments that could be one range.
+    class RangeSet
+    {
+    public:
+        RangeSet() = default;
+
+        explicit RangeSet( std::vector<Range> ranges )
+        {
+            std::ranges::sort( ranges, {}, &Range::start );
+            for( auto& range : ranges )
+            {
+                if( range.length <= 0 )
+                    continue;
+                if( !m_ranges.empty() && range.start <= m_ranges.back().start + m_ranges.back().length )
+                    m_ranges.back().length = std::max( m_ranges.back().length, range.start + range.length - m_ranges.back().start );
+                else
+                    m_ranges.push_back( range );
+            }
+        }
+
+        const std::vector<Range>& getRanges() const
+        {
+            return m_ranges;
+        }
+
+        bool empty() const
+        {
+            return m_ranges.empty();
+        }
+
+    private:
+        std::vector<Range> m_ranges;
+    };
+
     class RangeMap
     {
     public:
@@ -16,25 +52,159 @@ namespace Day5
             int64_t inputStart = 0;
             int64_t length = 0;
         };
-        void addSubMap( const SubMap& subMap )
+
+        // Values from inputStart up to the inputStart of the next segment are shifted by offset.
+        // The segments cover every int64_t, gaps between sub-maps are explicit segments with offset 0.
+        struct Segment
+        {
+            int64_t inputStart = 0;
+            int64_t offset = 0;
+        };
+
+        RangeMap()
+            : RangeMap( std::vector<Segment>{ { std::numeric_limits<int64_t>::min(), 0 } } )
         {
-            m_subMaps.push_back( subMap );
+        }
+
+        // Throws if sub-maps overlap, the input would map some values to two outputs.
+        explicit RangeMap( std::vector<SubMap> subMaps )
+        {
+            std::ranges::sort( subMaps, {}, &SubMap::inputStart );
+            auto isOverlapping = [] ( const SubMap& lhs, const SubMap& rhs ) { return rhs.inputStart < lhs.inputStart + lhs.length; };
+            if( std::ranges::adjacent_find( subMaps, isOverlapping ) != subMaps.end() )
+                throw std::runtime_error( "overlapping sub-maps" );
+            std::vector<Segment> segments;
+            appendSegment( segments, { std::numeric_limits<int64_t>::min(), 0 } );
+            for( auto& [outputStart, inputStart, length] : subMaps )
+            {
+                appendSegment( segments, { inputStart, outputStart - inputStart } );
+                appendSegment( segments, { inputStart + length, 0 } );
+            }
+            setSegments( segments );
         }
 
         int64_t getMappedValue( int64_t value ) const
         {
-            for( auto& [outputStart, inputStart, length] : m_subMaps )
+            return value + m_offsets[ getSegmentIndex( value ) ];
+        }
+
+        // Maps the values in blocks, every lane of a block runs the same branchless binary search over the segment starts,
+        // so the lanes can be vectorized as gathers and compares.
+        void getMappedValues( std::span<const int64_t> values, std::span<int64_t> mappedValues ) const
+        {
+            if( values.size() != mappedValues.size() )
+                throw std::runtime_error( "mismatching batch sizes" );
+            const auto numSegments = m_inputStarts.size();
+            const auto firstStep = std::bit_floor( numSegments );
+            for( size_t begin = 0; begin < values.size(); begin += batchBlockSize )
             {
-                if( value >= inputStart && value < inputStart + length )
-                    return value - inputStart + outputStart;
+                const auto blockSize = std::min( batchBlockSize, values.size() - begin );
+                std::array<int64_t, batchBlockSize> block{};
+                std::ranges::copy_n( values.begin() + begin, blockSize, block.begin() );
+
+                std::array<size_t, batchBlockSize> indices{};
+                for( auto step = firstStep; step > 0; step /= 2 )
+                {
+                    for( size_t lane = 0; lane < batchBlockSize; lane++ )
+                    {
+                        const auto probe = std::min( indices[ lane ] + step, numSegments - 1 );
+                        indices[ lane ] = m_inputStarts[ probe ] <= block[ lane ] ? probe : indices[ lane ];
+                    }
+                }
+                for( size_t lane = 0; lane < blockSize; lane++ )
+                    mappedValues[ begin + lane ] = block[ lane ] + m_offsets[ indices[ lane ] ];
+            }
+        }
+
+        // Minimum of getMappedValues, mapping one block at a time so the mapped values are never stored.
+        int64_t getMinMappedValue( std::span<const int64_t> values ) const
+        {
+            auto minValue = std::numeric_limits<int64_t>::max();
+            std::array<int64_t, batchBlockSize> block{};
+            for( size_t begin = 0; begin < values.size(); begin += batchBlockSize )
+            {
+                const auto mappedValues = std::span( block ).first( std::min( batchBlockSize, values.size() - begin ) );
+                getMappedValues( values.subspan( begin, mappedValues.size() ), mappedValues );
+                minValue = std::min( minValue, std::ranges::min( mappedValues ) );
             }
-            return value;
+            return minValue;
         }
 
+        // Returns the map of value -> next.getMappedValue( getMappedValue( value ) ).
+        RangeMap compose( const RangeMap& next ) const
+        {
+            std::vector<Segment> segments;
+            for( size_t index = 0; index < m_inputStarts.size(); index++ )
+            {
+                const auto offset = m_offsets[ index ];
+                const auto imageEnd = index + 1 == m_inputStarts.size() ? std::numeric_limits<int64_t>::max() : m_inputStarts[ index + 1 ] + offset;
+                auto imageStart = m_inputStarts[ index ] + offset;
+                for( auto nextIndex = next.getSegmentIndex( imageStart ); ; )
+                {
+                    appendSegment( segments, { imageStart - offset, offset + next.m_offsets[ nextIndex ] } );
+                    if( ++nextIndex == next.m_inputStarts.size() || next.m_inputStarts[ nextIndex ] >= imageEnd )
+                        break;
+                    imageStart = next.m_inputStarts[ nextIndex ];
+                }
+            }
+            return RangeMap( std::move( segments ) );
+        }
+
+        // Both the set and the segments are sorted, so one sweep over them splits every range at the segment borders.
+        RangeSet getMappedSet( const RangeSet& set ) const
+        {
+            std::vector<Range> mappedRanges;
+            if( set.empty() )
+                return {};
+            auto index = getSegmentIndex( set.getRanges().front().start );
+            for( auto& [start, length] : set.getRanges() )
+            {
+                const auto end = start + length;
+                while( index + 1 != m_inputStarts.size() && m_inputStarts[ index + 1 ] <= start )
+                    index++;
+                for( auto pieceStart = start; pieceStart < end; index++ )
+                {
+                    const auto pieceEnd = index + 1 == m_inputStarts.size() ? end : std::min( end, m_inputStarts[ index + 1 ] );
+                    mappedRanges.push_back( { pieceStart + m_offsets[ index ], pieceEnd - pieceStart } );
+                    if( pieceEnd == end )
+                        break;
+                    pieceStart = pieceEnd;
+                }
+            }
+            return RangeSet( std::move( mappedRanges ) );
+        }
 
-        std::vector<Range> getMappedRange( const Range& range ) const;
     private:
-        std::vector<SubMap> m_subMaps;
+        static constexpr size_t batchBlockSize = 8;
+
+        explicit RangeMap( const std::vector<Segment>& segments )
+        {
+            setSegments( segments );
+        }
+
+        // Appends a segment, dropping empty segments and merging neighbours with the same offset.
+        static void appendSegment( std::vector<Segment>& segments, const Segment& segment )
+        {
+            if( !segments.empty() && segments.back().inputStart == segment.inputStart )
+                segments.pop_back();
+            if( segments.empty() || segments.back().offset != segment.offset )
+                segments.push_back( segment );
+        }
+
+        void setSegments( const std::vector<Segment>& segments )
+        {
+            m_inputStarts = segments | std::views::transform( &Segment::inputStart ) | std::ranges::to<std::vector>();
+            m_offsets = segments | std::views::transform( &Segment::offset ) | std::ranges::to<std::vector>();
+        }
+
+        size_t getSegmentIndex( int64_t value ) const
+        {
+            return std::ranges::upper_bound( m_inputStarts, value ) - m_inputStarts.begin() - 1;
+        }
+
+        // segments as structure of arrays, the batch lookups only touch the starts while searching
+        std::vector<int64_t> m_inputStarts;
+        std::vector<int64_t> m_offsets;
     };
 
     struct Almanac
@@ -43,7 +213,7 @@ namespace Day5
         std::vector<RangeMap> maps;
     };
 
-    std::vector<int64_t> parseSeeds( const std::string& line )
+    std::vector<int64_t> parseSeeds( std::string_view line )
     {
         return line
             | std::views::drop_while( [] ( char c ) { return !std::isdigit( c ); } )
@@ -52,7 +222,7 @@ namespace Day5
             | std::ranges::to<std::vector>();
     }
 
-    RangeMap::SubMap parseSubMap( const std::string& line )
+    RangeMap::SubMap parseSubMap( std::string_view line )
     {
         auto parameters = line
             | std::views::split( ' ' )
@@ -60,109 +230,67 @@ namespace Day5
         return { *parameters.begin(), *std::next( parameters.begin(), 1 ), *std::next( parameters.begin(), 2 ) };
     }
 
-    RangeMap parseMap( std::istream& stream )
+    RangeMap parseMap( auto&& lines )
     {
-        RangeMap rangeMap;
-        for( std::string line; std::getline( stream, line ); )
-        {
-            if( line.empty() )
-                break;
-            rangeMap.addSubMap( parseSubMap( line ) );
-        }
-        return rangeMap;
+        std::vector<RangeMap::SubMap> subMaps;
+        for( std::string_view line : lines )
+            subMaps.push_back( parseSubMap( line ) );
+        return RangeMap( std::move( subMaps ) );
     }
 
-    Almanac parseInput( std::istream& stream )
+    Almanac parseInput( std::span<const std::string_view> lines )
     {
-        std::string line;
-        std::getline( stream, line );
-        Almanac almanac{ parseSeeds( line ) };
-        std::getline( stream, line );
+        if( lines.empty() )
+            throw std::runtime_error( "missing seeds" );
+        Almanac almanac{ parseSeeds( lines.front() ) };
+        if( almanac.seeds.empty() || almanac.seeds.size() % 2 != 0 )
+            throw std::runtime_error( "seeds have to be pairs of start and length" );
 
-        for( std::string line; std::getline( stream, line ); )
-            almanac.maps.push_back( parseMap( stream ) );
+        // maps are separated by empty lines and start with a header line
+        for( auto mapLines : lines | std::views::drop( 2 ) | std::views::split( std::string_view{} ) )
+            almanac.maps.push_back( parseMap( mapLines | std::views::drop( 1 ) ) );
         return almanac;
     }
 
-    int64_t getBestLocation( const Almanac& almanac )
+    RangeMap getSeedToLocationMap( const Almanac& almanac )
     {
-        std::vector<int64_t> mappedSeeds = almanac.seeds;
-        for( auto& mappedSeed : mappedSeeds )
-        {
-            for( auto& map : almanac.maps )
-                mappedSeed = map.getMappedValue( mappedSeed );
-        }
-        std::ranges::partial_sort( mappedSeeds, mappedSeeds.begin() + 1 );
-        return mappedSeeds[ 0 ];
-    }
-
-    Range convertTopRange( std::vector<Range>& inputRanges, const std::vector<RangeMap::SubMap>& subMaps )
-    {
-        auto currentRange = inputRanges.back();
-        inputRanges.pop_back();
-        for( auto& [outputStart, inputStart, length] : subMaps )
-        {
-            if( currentRange.start >= inputStart )
-            {
-                if( currentRange.start >= inputStart + length )
-                    continue;
-                // complete inside
-                if( currentRange.start + currentRange.length <= inputStart + length )
-                    return { currentRange.start - inputStart + outputStart, currentRange.length };
-                // end outside
-                inputRanges.push_back( { inputStart + length, ( currentRange.start + currentRange.length ) - ( inputStart + length ) } );
-                return { currentRange.start - inputStart + outputStart, inputStart + length - currentRange.start };
-            }
-            else if( currentRange.start + currentRange.length > inputStart )
-            {
-                inputRanges.push_back( { currentRange.start, inputStart - currentRange.start } );
-                // end inside
-                if( currentRange.start + currentRange.length <= inputStart + length )
-                    return { outputStart, currentRange.start + currentRange.length - inputStart };
-                // end outside
-                inputRanges.push_back( { inputStart + length, ( currentRange.start + currentRange.length ) - ( inputStart + length ) } );
-                return { outputStart, length };
-            }
-        }
-        return currentRange;
+        return std::accumulate( almanac.maps.begin(), almanac.maps.end(), RangeMap{}, [] ( const RangeMap& map, const RangeMap& next ) { return map.compose( next ); } );
     }
 
-    std::vector<Range> RangeMap::getMappedRange( const Range& range ) const
+    int64_t getBestLocation( const Almanac& almanac )
     {
-        std::vector<Range> inputRanges{ range };
-        std::vector<Range> outputRanges;
-        while( !inputRanges.empty() )
-            outputRanges.push_back( convertTopRange( inputRanges, m_subMaps ) );
-        return outputRanges;
+        return getSeedToLocationMap( almanac ).getMinMappedValue( almanac.seeds );
     }
 
     int64_t getBestLocation2( const Almanac& almanac )
     {
-        std::vector<std::vector<Range>> seedRanges = almanac.seeds
+        const auto seedRanges = almanac.seeds
             | std::views::chunk( 2 )
-            | std::views::transform( [] ( auto&& range ) { return std::vector<Range>{ Range{ *range.begin(), *std::next( range.begin() ) } }; } )
+            | std::views::transform( [] ( auto&& range ) { return Range{ *range.begin(), *std::next( range.begin() ) }; } )
             | std::ranges::to<std::vector>();
-        for( auto& seedRange : seedRanges )
-        {
+
+        // seed ranges are independent, each one is mapped through all stages on its own
+        std::vector<int64_t> bestLocations( seedRanges.size(), std::numeric_limits<int64_t>::max() );
+        parallelFor( seedRanges.size(), [ & ] ( size_t index ) {
+            RangeSet set( { seedRanges[ index ] } );
             for( auto& map : almanac.maps )
-            {
-                std::vector<Range> outRanges;
-                for( auto& range : seedRange )
-                    outRanges.append_range( map.getMappedRange( range ) );
-                seedRange = outRanges;
-            }
-        }
-        for( auto& range : seedRanges )
-            std::ranges::partial_sort( range, range.begin() + 1, [] ( auto& lhs, auto& rhs ) { return lhs.start < rhs.start; } );
-        std::ranges::partial_sort( seedRanges, seedRanges.begin() + 1, [] ( auto& lhs, auto& rhs ) { return lhs.front().start < rhs.front().start; } );
-        return seedRanges.front().front().start;
+                set = map.getMappedSet( set );
+            if( !set.empty() )
+                bestLocations[ index ] = set.getRanges().front().start;
+            } );
+        return std::ranges::min( bestLocations );
     }
 }
 
-void executeDay5()
+DayResult solveDay5( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/Day5.txt" );
-    auto almanac = Day5::parseInput( file );
-    fmt::print( "Best location: {}\n", Day5::getBestLocation( almanac ) );
-    fmt::print( "Best location2: {}\n", Day5::getBestLocation2( almanac ) );
+    auto almanac = Day5::parseInput( input.getLines() );
+    onPhaseDone( Phase::Parse );
+
+    DayResult result;
+    result.part1 = Day5::getBestLocation( almanac );
+    onPhaseDone( Phase::Part1 );
+    result.part2 = Day5::getBestLocation2( almanac );
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
@@ -1,4 +1,5 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day6
 {
@@ -16,24 +17,19 @@ namespace Day6
             | std::views::transform( [] ( auto range ) { return std::stoll( std::string( range.begin(), range.end() ) ); } );
     }
 
-    std::vector<BoatRace> parseInput( std::istream& stream )
+    std::vector<BoatRace> parseInput( std::span<const std::string_view> lines )
     {
-        std::string timeLine;
-        std::getline( stream, timeLine );
-        std::string distanceLine;
-        std::getline( stream, distanceLine );
+        if( lines.size() < 2 )
+            throw std::runtime_error( "missing time or distance line" );
+        const auto timeLine = lines[ 0 ];
+        const auto distanceLine = lines[ 1 ];
 
         return std::views::zip( timeLine | toNumbers(), distanceLine | toNumbers() )
             | std::views::transform( [] ( auto tuple ) { return BoatRace{ std::get<0>( tuple ), std::get<1>( tuple ) }; } )
             | std::ranges::to<std::vector>();
     }
 
-    int64_t getTotalPoints( const std::vector<BoatRace>& boatRaces )
-    {
-        return std::accumulate( boatRaces.begin(), boatRaces.end(), 1ll, [] ( int64_t result, auto& boatRace ) { return result * getBoatRacePoints( boatRace ); } );
-    }
-
-    auto getNumber( const std::string& line )
+    auto getNumber( std::string_view line )
     {
         auto result = line
             | std::views::drop_while( [] ( char c ) { return !std::isdigit( c ); } )
@@ -42,30 +38,91 @@ namespace Day6
         return std::stoll( std::string( result.begin(), result.end() ) );
     }
 
-    BoatRace parseInput2( std::istream& stream )
+    BoatRace parseInput2( std::span<const std::string_view> lines )
+    {
+        if( lines.size() < 2 )
+            throw std::runtime_error( "missing time or distance line" );
+        return { getNumber( lines[ 0 ] ), getNumber( lines[ 1 ] ) };
+    }
+
+    // h * ( time - h ) > distance, the division keeps it exact for every int64_t
+    bool isWinning( const BoatRace& boatRace, int64_t holdTime )
+    {
+        return holdTime > 0 && boatRace.time - holdTime > boatRace.distance / holdTime;
+    }
+
+    // Lower root of h * ( time - h ) = distance in the numerically stable form, it is close but not exact for large races.
+    int64_t getHoldTimeEstimate( const BoatRace& boatRace )
     {
-        std::string timeLine;
-        std::getline( stream, timeLine );
-        std::string distanceLine;
-        std::getline( stream, distanceLine );
+        const double time = static_cast<double>( boatRace.time );
+        const double distance = static_cast<double>( boatRace.distance );
+        const double discriminant = std::max( time * time - 4. * distance, 0. );
+        const double root = 2. * distance / ( time + std::sqrt( discriminant ) );
+        return static_cast<int64_t>( std::clamp( std::floor( root ) + 1., 0., time / 2. ) );
+    }
+
+    // Winning hold times are symmetric around time / 2, so searching for the first one from the estimate is enough.
+    int64_t getBoatRacePoints( const BoatRace& boatRace, int64_t estimate )
+    {
+        const auto half = boatRace.time / 2;
+        if( !isWinning( boatRace, half ) )
+            return 0;
 
-        return { getNumber( timeLine ), getNumber( distanceLine ) };
+        // widen [ low, high ] around the estimate until low loses and high wins, then bisect
+        auto low = estimate - 1;
+        auto high = estimate;
+        for( int64_t step = 1; low >= 0 && isWinning( boatRace, low ); step *= 2 )
+        {
+            high = low;
+            low = std::max<int64_t>( low - step, -1 );
+        }
+        for( int64_t step = 1; high < half && !isWinning( boatRace, high ); step *= 2 )
+        {
+            low = high;
+            high = std::min( high + step, half );
+        }
+        while( high - low > 1 )
+        {
+            const auto middle = low + ( high - low ) / 2;
+            ( isWinning( boatRace, middle ) ? high : low ) = middle;
+        }
+        return boatRace.time - 2 * high + 1;
     }
 
     int64_t getBoatRacePoints( const BoatRace& boatRace )
     {
-        auto minTime = std::ceil( boatRace.time / 2. - sqrt( ( boatRace.time * boatRace.time / 4. ) - boatRace.distance ) );
-        auto maxTime = std::floor( boatRace.time / 2. + sqrt( ( boatRace.time * boatRace.time / 4. ) - boatRace.distance ) );
+        return getBoatRacePoints( boatRace, getHoldTimeEstimate( boatRace ) );
+    }
+
+    // The estimates are computed in a loop of their own so the floating point part can be vectorized,
+    // the exact correction runs afterwards.
+    void getBoatRacePoints( std::span<const BoatRace> boatRaces, std::span<int64_t> points )
+    {
+        if( boatRaces.size() != points.size() )
+            throw std::runtime_error( "mismatching batch sizes" );
+        std::ranges::transform( boatRaces, points.begin(), [] ( const BoatRace& boatRace ) { return getHoldTimeEstimate( boatRace ); } );
+        for( size_t index = 0; index < boatRaces.size(); index++ )
+            points[ index ] = getBoatRacePoints( boatRaces[ index ], points[ index ] );
+    }
 
-        return maxTime - minTime + 1;
+    int64_t getTotalPoints( const std::vector<BoatRace>& boatRaces )
+    {
+        std::vector<int64_t> points( boatRaces.size() );
+        getBoatRacePoints( boatRaces, points );
+        return std::accumulate( points.begin(), points.end(), 1ll, std::multiplies<>() );
     }
 }
 
-void executeDay6()
+DayResult solveDay6( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/Day6.txt" );
-    auto boatRaces = Day6::parseInput( file );
-    fmt::print( "Get total points: {}\n", Day6::getTotalPoints( boatRaces ) );
-    file.seekg( 0 );
-    fmt::print( "Get actual points: {}\n", Day6::getBoatRacePoints( Day6::parseInput2( file ) ) );
+    auto boatRaces = Day6::parseInput( input.getLines() );
+    auto boatRace = Day6::parseInput2( input.getLines() );
+    onPhaseDone( Phase::Parse );
+
+    DayResult result;
+    result.part1 = Day6::getTotalPoints( boatRaces );
+    onPhaseDone( Phase::Part1 );
+    result.part2 = Day6::getBoatRacePoints( boatRace );
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
@@ -1,4 +1,5 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day7
 {
@@ -43,20 +44,26 @@ namespace Day7
         return static_cast<T>( lhs ) <=> static_cast<T>( rhs );
     }
 
+    using Cards = std::array<Card, 5>;
+
+    // both rankings are known after parsing, a hand only keeps its two sort keys
     struct Hand
     {
-        std::vector<Card> cards;
+        uint32_t sortKey;
+        uint32_t jokerSortKey;
         int64_t bet;
-        HandValue handValue;
-        HandValue jokerHandValue;
-        bool operator<( const Hand& rhs ) const
-        {
-            if( handValue == rhs.handValue )
-                return cards < rhs.cards;
-            return handValue < rhs.handValue;
-        }
     };
 
+    // A hand packed into one integer that grows with the strength of the hand: the hand value above five 4-bit card ranks,
+    // first card in the highest nibble. Jokers get rank 0, so the same layout works for both rankings.
+    uint32_t getSortKey( HandValue handValue, const Cards& cards )
+    {
+        auto key = static_cast<uint32_t>( HandValue::HighCard ) - static_cast<uint32_t>( handValue );
+        for( auto card : cards )
+            key = ( key << 4 ) | ( static_cast<uint32_t>( Card::Joker ) - static_cast<uint32_t>( card ) );
+        return key;
+    }
+
     Card toCard( char c )
     {
         switch( c )
@@ -92,144 +99,136 @@ namespace Day7
         }
     }
 
-    HandValue getHandValue( const std::array<int64_t, 5>& numCards )
+    HandValue getHandValue( int64_t largestCount, int64_t secondLargestCount )
     {
-        if( numCards[ 4 ] == 1 )
+        if( largestCount == 5 )
             return HandValue::Five;
-        if( numCards[ 3 ] == 1 )
+        if( largestCount == 4 )
             return HandValue::Four;
-        if( numCards[ 2 ] == 1 && numCards[ 1 ] == 1 )
-            return HandValue::Fullhouse;
-        if( numCards[ 1 ] == 2 )
-            return HandValue::TwoPair;
-        if( numCards[ 2 ] == 1 )
-            return HandValue::Three;
-        if( numCards[ 1 ] == 1 )
-            return HandValue::Pair;
+        if( largestCount == 3 )
+            return secondLargestCount == 2 ? HandValue::Fullhouse : HandValue::Three;
+        if( largestCount == 2 )
+            return secondLargestCount == 2 ? HandValue::TwoPair : HandValue::Pair;
         return HandValue::HighCard;
     }
 
-    HandValue getHandValue( const std::vector<Card>& cards )
+    struct HandValues
     {
-        std::multiset<Card> sortedCards = cards | std::ranges::to<std::multiset>();
-        std::array<int64_t, 5> numCards{ 0 };
-        for( auto it = sortedCards.begin(); it != sortedCards.end(); )
-        {
-            auto count = sortedCards.count( *it );
-            numCards[ count - 1 ]++;
-            std::advance( it, count );
-        }
-        return getHandValue( numCards );
-    }
+        HandValue normal;
+        HandValue joker;
+    };
 
-    HandValue getJokerHandValue( const std::vector<Card>& cards )
+    // Both values come from one count per card. Jokers always do best joining the most common other card.
+    HandValues getHandValues( const Cards& cards )
     {
-        std::multiset<Card> sortedCards = cards | std::ranges::to<std::multiset>();
-        std::array<int64_t, 5> numCards{ 0 };
-        int64_t numJokers = 0;
-        for( auto it = sortedCards.begin(); it != sortedCards.end(); )
+        std::array<int64_t, static_cast<size_t>( Card::Joker ) + 1> counts{};
+        for( auto card : cards )
+            counts[ static_cast<size_t>( card ) ]++;
+
+        const auto numJacks = counts[ static_cast<size_t>( Card::Jack ) ];
+        // the two largest counts, in descending order
+        std::array<int64_t, 2> largest{};
+        std::array<int64_t, 2> largestWithoutJacks{};
+        auto addCount = [] ( std::array<int64_t, 2>& top, int64_t count ) {
+            if( count > top[ 0 ] )
+                top = { count, top[ 0 ] };
+            else if( count > top[ 1 ] )
+                top[ 1 ] = count;
+            };
+        for( size_t card = 0; card < counts.size(); card++ )
         {
-            auto count = sortedCards.count( *it );
-            if( *it == Card::Jack )
-                numJokers += count;
-            else
-                numCards[ count - 1 ]++;
-            std::advance( it, count );
+            addCount( largest, counts[ card ] );
+            if( card != static_cast<size_t>( Card::Jack ) )
+                addCount( largestWithoutJacks, counts[ card ] );
         }
-        if( numJokers == 5 )
-            return HandValue::Five;
-        auto handValue = getHandValue( numCards );
-        switch( handValue )
-        {
-            case HandValue::Five:
-                return HandValue::Five;
-            case HandValue::Four:
-                if( numJokers == 1 )
-                    return HandValue::Five;
-                return HandValue::Four;
-            case HandValue::Fullhouse:
-                return HandValue::Fullhouse;
-            case HandValue::Three:
-                if( numJokers == 1 )
-                    return HandValue::Four;
-                if( numJokers == 2 )
-                    return HandValue::Five;
-                return HandValue::Three;
-            case HandValue::TwoPair:
-                if( numJokers == 1 )
-                    return HandValue::Fullhouse;
-                return HandValue::TwoPair;
-            case HandValue::Pair:
-                if( numJokers == 1 )
-                    return HandValue::Three;
-                if( numJokers == 2 )
-                    return HandValue::Four;
-                if( numJokers == 3 )
-                    return HandValue::Five;
-                return HandValue::Pair;
-            case HandValue::HighCard:
-                if( numJokers == 1 )
-                    return HandValue::Pair;
-                if( numJokers == 2 )
-                    return HandValue::Three;
-                if( numJokers == 3 )
-                    return HandValue::Four;
-                if( numJokers == 4 )
-                    return HandValue::Five;
-        }
-        return HandValue::HighCard;
+        return { getHandValue( largest[ 0 ], largest[ 1 ] ), getHandValue( largestWithoutJacks[ 0 ] + numJacks, largestWithoutJacks[ 1 ] ) };
     }
 
-    Hand parseHand( const std::string& line )
+    Hand parseHand( std::string_view line )
     {
         auto betString = line
             | std::views::drop_while( [] ( auto c ) {return c != ' '; } );
 
         int64_t bet = std::stoll( std::string( betString.begin(), betString.end() ) );
-        auto cards = line
-            | std::views::take( 5 )
-            | std::views::transform( toCard )
-            | std::ranges::to<std::vector>();
+        Cards cards;
+        std::ranges::copy( line | std::views::take( cards.size() ) | std::views::transform( toCard ), cards.begin() );
 
-        return { cards, bet, getHandValue( cards ), getJokerHandValue( cards ) };
+        const auto [handValue, jokerHandValue] = getHandValues( cards );
+        const auto sortKey = getSortKey( handValue, cards );
+        std::ranges::replace( cards, Card::Jack, Card::Joker );
+        return { sortKey, getSortKey( jokerHandValue, cards ), bet };
     }
 
-    std::vector<Hand> parseInput( std::istream& stream )
+    std::vector<Hand> parseInput( std::span<const std::string_view> lines )
     {
         std::vector<Hand> hands;
-        for( std::string line; std::getline( stream, line ); )
+        hands.reserve( lines.size() );
+        for( auto line : lines )
             hands.push_back( parseHand( line ) );
         return hands;
     }
 
-    int64_t getTotalWinnings( std::vector<Hand> hands )
+    // LSD radix sort of the hands by one of their sort keys, 8 bits per pass. Each entry packs the key above the index of
+    // its hand, so a ranking only needs two 8 byte buffers per hand. The last pass moves every hand to its final rank,
+    // so the winnings are summed while scattering.
+    int64_t getTotalWinnings( const std::vector<Hand>& hands, uint32_t Hand::* sortKey )
     {
-        std::sort( hands.begin(), hands.end() );
-        auto points = hands
-            | std::views::reverse
-            | std::views::enumerate
-            | std::views::transform( [] ( auto tuple ) { return ( std::get<0>( tuple ) + 1 ) * std::get<1>( tuple ).bet; } )
-            | std::ranges::to<std::vector>();
-
-        return std::accumulate( points.begin(), points.end(), 0ll );
-    }
-
-    int64_t getTotalJokerWinnings( std::vector<Hand> hands )
-    {
-        for( auto& hand : hands )
+        constexpr uint32_t digitBits = 8;
+        constexpr uint32_t keyBits = 23;
+        constexpr uint32_t indexBits = 32;
+        if( hands.size() > std::numeric_limits<uint32_t>::max() )
+            throw std::runtime_error( "too many hands" );
+
+        std::vector<uint64_t> entries( hands.size() );
+        for( size_t index = 0; index < hands.size(); index++ )
+            entries[ index ] = static_cast<uint64_t>( hands[ index ].*sortKey ) << indexBits | index;
+        std::vector<uint64_t> sortedEntries( hands.size() );
+
+        int64_t totalWinnings = 0;
+        for( uint32_t shift = indexBits; shift < indexBits + keyBits; shift += digitBits )
         {
-            std::ranges::replace( hand.cards, Card::Jack, Card::Joker );
-            hand.handValue = hand.jokerHandValue;
+            std::array<size_t, 1 << digitBits> offsets{};
+            for( auto entry : entries )
+                offsets[ ( entry >> shift ) & ( offsets.size() - 1 ) ]++;
+            std::exclusive_scan( offsets.begin(), offsets.end(), offsets.begin(), size_t{ 0 } );
+
+            const bool isLastPass = shift + digitBits >= indexBits + keyBits;
+            for( auto entry : entries )
+            {
+                const auto rank = offsets[ ( entry >> shift ) & ( offsets.size() - 1 ) ]++;
+                sortedEntries[ rank ] = entry;
+                if( isLastPass )
+                    totalWinnings += static_cast<int64_t>( rank + 1 ) * hands[ static_cast<uint32_t>( entry ) ].bet;
+            }
+            std::swap( entries, sortedEntries );
         }
+        return totalWinnings;
+    }
 
-        return getTotalWinnings( std::move( hands ) );
+    // Returns the winnings of both rankings, large inputs sort for both at the same time.
+    std::array<int64_t, 2> getTotalWinnings( const std::vector<Hand>& hands )
+    {
+        constexpr size_t minParallelSize = 4096;
+        constexpr std::array sortKeys = { &Hand::sortKey, &Hand::jokerSortKey };
+        std::array<int64_t, 2> totalWinnings{};
+        parallelFor( sortKeys.size(), hands.size() < minParallelSize ? 1 : sortKeys.size(), [ & ] ( size_t ranking ) {
+            totalWinnings[ ranking ] = getTotalWinnings( hands, sortKeys[ ranking ] );
+            } );
+        return totalWinnings;
     }
 }
 
-void executeDay7()
+DayResult solveDay7( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/day7.txt" );
-    auto hands = Day7::parseInput( file );
-    fmt::print( "Total winning points: {}\n", Day7::getTotalWinnings( hands ) );
-    fmt::print( "Total winning points with joker: {}\n", Day7::getTotalJokerWinnings( hands ) );
+    auto hands = Day7::parseInput( input.getLines() );
+    onPhaseDone( Phase::Parse );
+
+    // both parts are ranked together, so part 2 is already done when part 1 is
+    DayResult result;
+    const auto [totalWinnings, totalJokerWinnings] = Day7::getTotalWinnings( hands );
+    result.part1 = totalWinnings;
+    onPhaseDone( Phase::Part1 );
+    result.part2 = totalJokerWinnings;
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
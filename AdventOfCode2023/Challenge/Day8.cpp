@@ -1,96 +1,354 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day8
 {
-    using NodeId = std::array<char, 3>;
-    using NodeMap = std::map<NodeId, std::pair<NodeId, NodeId>>;
+    // node names are three base-36 digits (0-9, A-Z)
+    using NodeId = uint32_t;
+    constexpr NodeId numNodeIds = 36 * 36 * 36;
+
+    struct Node
+    {
+        NodeId id;
+        NodeId left;
+        NodeId right;
+    };
+
+    // The graph with nodes numbered densely in input order, the walks only touch these flat arrays.
+    struct Network
+    {
+        std::vector<NodeId> ids;
+        std::vector<uint32_t> left;
+        std::vector<uint32_t> right;
+        std::vector<bool> isStart; // id ends with A
+        std::vector<bool> isEnd; // id ends with Z
+    };
+
+    struct EndHit
+    {
+        uint32_t offset; // steps into the pass
+        uint32_t node;
+    };
+
+    // Where one full pass over the instructions leads from every node and which end nodes it passes on the way.
+    // Level k of the binary lifting tables covers 2^k passes.
+    struct PassTable
+    {
+        std::vector<std::vector<EndHit>> endHits;
+        std::vector<std::vector<uint32_t>> targets;
+        std::vector<std::vector<bool>> hasEndHit;
+    };
+
     struct MapData
     {
-        std::string  instructions;
-        NodeMap nodes;
+        std::string instructions;
+        Network network;
+        PassTable passTable;
     };
 
-    NodeId toNodeId( const std::string& node )
+    NodeId toDigit( char c )
+    {
+        if( c >= '0' && c <= '9' )
+            return c - '0';
+        if( c >= 'A' && c <= 'Z' )
+            return c - 'A' + 10;
+        throw std::runtime_error( "invalid node" );
+    }
+
+    NodeId toNodeId( std::string_view node )
     {
-        return { node[ 0 ], node[ 1 ], node[ 2 ] };
+        NodeId id = 0;
+        for( char c : node )
+            id = id * 36 + toDigit( c );
+        return id;
     }
 
-    void addNode( NodeMap& nodeMap, const std::string& line )
+    Node parseNode( std::string_view line )
     {
-        static std::regex regex( R"((\w\w\w) = \((\w\w\w), (\w\w\w)\))" );
-        std::smatch match;
-        if( !std::regex_match( line, match, regex ) )
+        Scanner scanner( line );
+        const auto node = scanner.readWord();
+        const auto left = scanner.expect( " = (" ) ? scanner.readWord() : std::string_view{};
+        const auto right = scanner.expect( ", " ) ? scanner.readWord() : std::string_view{};
+        if( node.size() != 3 || left.size() != 3 || right.size() != 3 || !scanner.expect( ")" ) || !scanner.atEnd() )
             throw std::runtime_error( "invalid node" );
-        nodeMap.emplace( toNodeId( match[ 1 ] ), std::pair{ toNodeId( match[ 2 ] ), toNodeId( match[ 3 ] ) } );
+        return { toNodeId( node ), toNodeId( left ), toNodeId( right ) };
     }
 
-    MapData parseInput( std::istream& stream )
+    Network compileNetwork( std::span<const Node> nodes )
     {
-        MapData mapData;
-        std::getline( stream, mapData.instructions );
+        constexpr uint32_t noIndex = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> indices( numNodeIds, noIndex );
+        for( uint32_t index = 0; index < nodes.size(); index++ )
+            indices[ nodes[ index ].id ] = index;
+        auto getIndex = [ & ] ( NodeId id ) {
+            if( indices[ id ] == noIndex )
+                throw std::runtime_error( "unknown node" );
+            return indices[ id ];
+            };
 
-        std::string line;
-        std::getline( stream, line );
-        for( ; std::getline( stream, line ); )
-            addNode( mapData.nodes, line );
-        return mapData;
+        Network network;
+        for( auto& [id, left, right] : nodes )
+        {
+            network.ids.push_back( id );
+            network.left.push_back( getIndex( left ) );
+            network.right.push_back( getIndex( right ) );
+            network.isStart.push_back( id % 36 == toDigit( 'A' ) );
+            network.isEnd.push_back( id % 36 == toDigit( 'Z' ) );
+        }
+        return network;
     }
 
-    int64_t getMinNumberOfSteps( const MapData& mapData )
+    PassTable buildPassTable( std::string_view instructions, const Network& network )
     {
-        auto currentNode = mapData.nodes.find( NodeId{ 'A', 'A', 'A' } );
-        auto currentInstruction = mapData.instructions.begin();
-        int64_t numberOfSteps = 0;
-        while( currentNode->first != NodeId{ 'Z', 'Z','Z' } )
+        const auto numNodes = network.ids.size();
+        PassTable passTable;
+        passTable.endHits.resize( numNodes );
+        passTable.targets.emplace_back( numNodes );
+        passTable.hasEndHit.emplace_back( numNodes );
+        parallelFor( numNodes, [ & ] ( size_t node ) {
+            auto currentNode = static_cast<uint32_t>( node );
+            for( uint32_t offset = 0; offset < instructions.size(); offset++ )
+            {
+                if( network.isEnd[ currentNode ] )
+                    passTable.endHits[ node ].push_back( { offset, currentNode } );
+                currentNode = instructions[ offset ] == 'L' ? network.left[ currentNode ] : network.right[ currentNode ];
+            }
+            passTable.targets[ 0 ][ node ] = currentNode;
+            } );
+        for( size_t node = 0; node < numNodes; node++ )
+            passTable.hasEndHit[ 0 ][ node ] = !passTable.endHits[ node ].empty();
+
+        // more than numNodes passes always repeat a node, so higher levels are never needed
+        for( size_t level = 1; ( size_t{ 1 } << ( level - 1 ) ) <= numNodes; level++ )
         {
-            numberOfSteps++;
-            if( *currentInstruction == 'L' )
-                currentNode = mapData.nodes.find( currentNode->second.first );
-            else
-                currentNode = mapData.nodes.find( currentNode->second.second );
-            currentInstruction++;
-            if( currentInstruction == mapData.instructions.end() )
-                currentInstruction = mapData.instructions.begin();
+            const auto& targets = passTable.targets[ level - 1 ];
+            const auto& hasEndHit = passTable.hasEndHit[ level - 1 ];
+            std::vector<uint32_t> nextTargets( numNodes );
+            std::vector<bool> nextHasEndHit( numNodes );
+            for( size_t node = 0; node < numNodes; node++ )
+            {
+                nextTargets[ node ] = targets[ targets[ node ] ];
+                nextHasEndHit[ node ] = hasEndHit[ node ] || hasEndHit[ targets[ node ] ];
+            }
+            passTable.targets.push_back( std::move( nextTargets ) );
+            passTable.hasEndHit.push_back( std::move( nextHasEndHit ) );
         }
-        return numberOfSteps;
+        return passTable;
     }
 
-    int64_t getMinNumberOfSteps2( const MapData& mapData )
+    MapData parseInput( std::span<const std::string_view> lines )
     {
-        auto currentNodes = mapData.nodes
-            | std::views::filter( [] ( auto& node ) { return node.first[ 2 ] == 'A'; } )
-            | std::views::transform( [] ( auto& node ) { return std::pair<NodeId, std::pair<NodeId, NodeId>>{ node.first, { node.second.first, node.second.second } }; } )
+        if( lines.empty() )
+            throw std::runtime_error( "missing instructions" );
+        const auto nodes = lines
+            | std::views::drop( 2 )
+            | std::views::transform( parseNode )
             | std::ranges::to<std::vector>();
+        auto instructions = std::string( lines.front() );
+        auto network = compileNetwork( nodes );
+        auto passTable = buildPassTable( instructions, network );
+        return { std::move( instructions ), std::move( network ), std::move( passTable ) };
+    }
 
-        auto currentInstruction = mapData.instructions.begin();
-        std::vector<int64_t> numberOfSteps( currentNodes.size() );
-        for( int64_t nodeId = 0; auto& node : currentNodes )
+    uint32_t getNodeIndex( const Network& network, std::string_view node )
+    {
+        const auto found = std::ranges::find( network.ids, toNodeId( node ) );
+        if( found == network.ids.end() )
+            throw std::runtime_error( fmt::format( "missing node {}", node ) );
+        return static_cast<uint32_t>( found - network.ids.begin() );
+    }
+
+    // Skips every pass without an end node in O( log passes ) table lookups and only looks at the passes with end hits.
+    int64_t getMinNumberOfSteps( const MapData& mapData )
+    {
+        const auto& [instructions, network, passTable] = mapData;
+        auto currentNode = getNodeIndex( network, "AAA" );
+        const auto endNode = getNodeIndex( network, "ZZZ" );
+        for( int64_t pass = 0; pass <= ssize( network.ids ); pass++ )
         {
-            while( node.first[ 2 ] != 'Z' )
+            for( auto level = passTable.targets.size(); level-- > 0; )
             {
-                numberOfSteps[nodeId]++;
-                if( *currentInstruction == 'L' )
-                    node = *mapData.nodes.find( node.second.first );
-                else
-                    node = *mapData.nodes.find( node.second.second );
-                currentInstruction++;
-                if( currentInstruction == mapData.instructions.end() )
-                    currentInstruction = mapData.instructions.begin();
+                if( !passTable.hasEndHit[ level ][ currentNode ] )
+                {
+                    currentNode = passTable.targets[ level ][ currentNode ];
+                    pass += 1ll << level;
+                }
             }
-            nodeId++;
+            for( auto& [offset, node] : passTable.endHits[ currentNode ] )
+            {
+                if( node == endNode )
+                    return pass * ssize( instructions ) + offset;
+            }
+            currentNode = passTable.targets[ 0 ][ currentNode ];
+        }
+        throw std::runtime_error( "ZZZ is not reachable" );
+    }
+
+    // The steps at which a ghost stands on an end node. From cycleStart on the walk repeats every cycleLength steps,
+    // endSteps holds every end step before cycleStart + cycleLength in ascending order.
+    struct Walk
+    {
+        int64_t cycleStart = 0;
+        int64_t cycleLength = 0;
+        std::vector<int64_t> endSteps;
+
+        bool isAtEnd( int64_t step ) const
+        {
+            if( step >= cycleStart )
+                step = cycleStart + ( step - cycleStart ) % cycleLength;
+            return std::ranges::binary_search( endSteps, step );
+        }
+    };
+
+    // The state of a walk is ( node, instruction index ), checking it at the start of every instruction pass is enough
+    // to find a repetition, so only one entry per node is needed. The walk moves a whole pass per lookup.
+    Walk walkGhost( const MapData& mapData, uint32_t startNode )
+    {
+        const auto& [instructions, network, passTable] = mapData;
+        const auto numInstructions = ssize( instructions );
+        std::vector<int64_t> firstPass( network.ids.size(), -1 );
+        Walk walk;
+        int64_t pass = 0;
+        auto currentNode = startNode;
+        for( ; firstPass[ currentNode ] < 0; pass++ )
+        {
+            firstPass[ currentNode ] = pass;
+            for( auto& endHit : passTable.endHits[ currentNode ] )
+                walk.endSteps.push_back( pass * numInstructions + endHit.offset );
+            currentNode = passTable.targets[ 0 ][ currentNode ];
         }
+        walk.cycleStart = firstPass[ currentNode ] * numInstructions;
+        walk.cycleLength = pass * numInstructions - walk.cycleStart;
+        return walk;
+    }
 
-        auto result = numberOfSteps.front();
-        for( auto& steps : numberOfSteps )
-            result = std::lcm( result, steps );
+    // x == remainder modulo modulus
+    struct Congruence
+    {
+        int64_t remainder = 0;
+        int64_t modulus = 1;
+    };
+
+    int64_t getMultipliedModulo( int64_t lhs, int64_t rhs, int64_t modulus )
+    {
+        int64_t result = 0;
+        for( lhs %= modulus; rhs > 0; rhs /= 2 )
+        {
+            if( rhs % 2 == 1 )
+                result = ( result + lhs ) % modulus;
+            lhs = ( lhs + lhs ) % modulus;
+        }
         return result;
     }
+
+    // inverse of value modulo modulus, value and modulus have to be coprime
+    int64_t getInverseModulo( int64_t value, int64_t modulus )
+    {
+        int64_t oldR = value % modulus, r = modulus;
+        int64_t oldS = 1, s = 0;
+        while( r != 0 )
+        {
+            const auto quotient = oldR / r;
+            oldR = std::exchange( r, oldR - quotient * r );
+            oldS = std::exchange( s, oldS - quotient * s );
+        }
+        return ( oldS % modulus + modulus ) % modulus;
+    }
+
+    // Chinese remainder theorem for moduli that don't have to be coprime.
+    std::optional<Congruence> combine( const Congruence& lhs, const Congruence& rhs )
+    {
+        const auto divisor = std::gcd( lhs.modulus, rhs.modulus );
+        const auto difference = ( ( rhs.remainder - lhs.remainder ) % rhs.modulus + rhs.modulus ) % rhs.modulus;
+        if( difference % divisor != 0 )
+            return std::nullopt;
+        const auto reducedModulus = rhs.modulus / divisor;
+        if( lhs.modulus > std::numeric_limits<int64_t>::max() / reducedModulus )
+            throw std::runtime_error( "ghost cycles are too long" );
+        const auto factor = getMultipliedModulo( difference / divisor, getInverseModulo( lhs.modulus / divisor % reducedModulus, reducedModulus ), reducedModulus );
+        return Congruence{ lhs.remainder + lhs.modulus * factor, lhs.modulus * reducedModulus };
+    }
+
+    int64_t getFirstCommonEndStep( const std::vector<Walk>& walks )
+    {
+        const auto allCyclesStart = std::ranges::max( walks | std::views::transform( &Walk::cycleStart ) );
+
+        // before every walk is inside its cycle, test the end steps of the first walk against the others
+        const auto& firstWalk = walks.front();
+        std::vector<int64_t> candidates;
+        for( auto step : firstWalk.endSteps )
+        {
+            for( ; step < allCyclesStart; step += firstWalk.cycleLength )
+            {
+                candidates.push_back( step );
+                if( step < firstWalk.cycleStart )
+                    break;
+            }
+        }
+        std::ranges::sort( candidates );
+        for( auto step : candidates )
+        {
+            if( std::ranges::all_of( walks, [ & ] ( auto& walk ) { return walk.isAtEnd( step ); } ) )
+                return step;
+        }
+
+        // afterwards every walk is periodic, every end step in a cycle is one possible congruence of the walk
+        std::vector<Congruence> congruences{ Congruence{} };
+        for( auto& walk : walks )
+        {
+            std::vector<Congruence> combined;
+            for( auto& congruence : congruences )
+            {
+                for( auto step : walk.endSteps | std::views::filter( [ & ] ( int64_t step ) { return step >= walk.cycleStart; } ) )
+                {
+                    if( auto result = combine( congruence, { step % walk.cycleLength, walk.cycleLength } ) )
+                        combined.push_back( *result );
+                }
+            }
+            // all combined congruences share the same modulus
+            std::ranges::sort( combined, {}, &Congruence::remainder );
+            const auto duplicates = std::ranges::unique( combined, {}, &Congruence::remainder );
+            combined.erase( duplicates.begin(), duplicates.end() );
+            congruences = std::move( combined );
+        }
+        if( congruences.empty() )
+            throw std::runtime_error( "ghosts never reach end nodes at the same time" );
+
+        auto getFirstStep = [ & ] ( const Congruence& congruence ) {
+            if( congruence.remainder >= allCyclesStart )
+                return congruence.remainder;
+            return congruence.remainder + ( allCyclesStart - congruence.remainder + congruence.modulus - 1 ) / congruence.modulus * congruence.modulus;
+            };
+        return std::ranges::min( congruences | std::views::transform( getFirstStep ) );
+    }
+
+    int64_t getMinNumberOfSteps2( const MapData& mapData )
+    {
+        const auto& network = mapData.network;
+        const auto startNodes = std::views::iota( 0u, static_cast<uint32_t>( network.ids.size() ) )
+            | std::views::filter( [ & ] ( uint32_t node ) { return network.isStart[ node ]; } )
+            | std::ranges::to<std::vector>();
+        if( startNodes.empty() )
+            throw std::runtime_error( "no start nodes" );
+
+        // the ghosts are independent until their walks are combined
+        std::vector<Walk> walks( startNodes.size() );
+        parallelFor( startNodes.size(), [ & ] ( size_t index ) {
+            walks[ index ] = walkGhost( mapData, startNodes[ index ] );
+            } );
+        return getFirstCommonEndStep( walks );
+    }
 }
 
-void executeDay8()
+DayResult solveDay8( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/Day8.txt" );
-    auto mapData = Day8::parseInput( file );
-    fmt::print( "Minimum number of steps: {}\n", Day8::getMinNumberOfSteps( mapData ) );
-    fmt::print( "Minimum number of steps: {}\n", Day8::getMinNumberOfSteps2( mapData ) );
+    auto mapData = Day8::parseInput( input.getLines() );
+    onPhaseDone( Phase::Parse );
+
+    DayResult result;
+    result.part1 = Day8::getMinNumberOfSteps( mapData );
+    onPhaseDone( Phase::Part1 );
+    result.part2 = Day8::getMinNumberOfSteps2( mapData );
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
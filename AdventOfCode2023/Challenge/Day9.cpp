@@ -1,70 +1,140 @@
 #include "Utilities.h"
+#include "../Challenges.h"
 
 namespace Day9
 {
-    using History = std::vector<int64_t>;
-    std::vector<History> parseInput( std::istream& stream )
-    {
-        std::vector<History> histories;
-        for( std::string line; std::getline( stream, line ); )
-            histories.push_back( line
-                | std::views::split( ' ' )
-                | std::views::transform( [] ( auto range ) { return std::stoll( std::string( range.begin(), range.end() ) ); } )
-                | std::ranges::to<std::vector>() );
-        return histories;
-    }
+    using History = std::span<const int64_t>;
 
-    int64_t getExtrapolatedValue( const History& history )
+    // All histories in one buffer, history i is values[ offsets[ i ] ] up to values[ offsets[ i + 1 ] ].
+    struct Histories
     {
-        std::vector<History> extrapolations{ history };
+        std::vector<int64_t> values;
+        std::vector<size_t> offsets{ 0 };
 
-        while( !std::ranges::all_of( extrapolations.back(), [] ( auto v ) { return v == 0; } ) )
+        size_t size() const
         {
-            extrapolations.push_back( extrapolations.back()
-                | std::views::adjacent<2>
-                | std::views::transform( [] ( auto tuple ) { return std::get<1>( tuple ) - std::get<0>( tuple ); } )
-                | std::ranges::to<std::vector>() );
+            return offsets.size() - 1;
         }
 
-        auto lastNumbers = extrapolations | std::views::transform( [] ( auto range ) { return range.back(); } );
-        return std::accumulate( lastNumbers.begin(), lastNumbers.end(), 0ll );
-    }
+        History get( size_t index ) const
+        {
+            return History( values ).subspan( offsets[ index ], offsets[ index + 1 ] - offsets[ index ] );
+        }
+    };
 
-    int64_t getSumOfExtropolatedHistories( const std::vector<History>& histories )
+    Histories parseInput( std::span<const std::string_view> lines )
     {
-        return std::accumulate( histories.begin(), histories.end(), 0ll, [] ( auto sum, auto history ) { return sum + getExtrapolatedValue( history ); } );
+        Histories histories;
+        histories.offsets.reserve( lines.size() + 1 );
+        for( auto line : lines )
+        {
+            for( Scanner scanner( line ); scanner.skipSpaces(), !scanner.atEnd(); )
+            {
+                const auto value = scanner.readInteger();
+                if( !value )
+                    throw std::runtime_error( "invalid history" );
+                histories.values.push_back( *value );
+            }
+            histories.offsets.push_back( histories.values.size() );
+        }
+        return histories;
     }
 
-    int64_t getNegativeExtrapolatedValue( const History& history )
+    // Extrapolating through the difference rows is a fixed linear combination of the history, the weights are signed
+    // binomial coefficients. The arithmetic wraps modulo 2^64, which is exact whenever the result fits into int64_t.
+    struct Weights
+    {
+        std::vector<uint64_t> next;
+        std::vector<uint64_t> previous;
+    };
+
+    // Inverse of an odd number modulo 2^64, every Newton step doubles the number of correct low bits.
+    uint64_t getInverse( uint64_t odd )
     {
-        std::vector<History> extrapolations{ history };
+        uint64_t inverse = odd;
+        for( int step = 0; step < 5; step++ )
+            inverse *= 2 - odd * inverse;
+        return inverse;
+    }
 
-        while( !std::ranges::all_of( extrapolations.back(), [] ( auto v ) { return v == 0; } ) )
+    // Row n of Pascal's triangle modulo 2^64 in O( n ) from C( n, k ) = C( n, k - 1 ) * ( n - k + 1 ) / k. Only the odd
+    // part of k can be divided out with an inverse, its powers of two are tracked as an exponent instead.
+    std::vector<uint64_t> getBinomials( uint64_t n )
+    {
+        std::vector<uint64_t> binomials{ 1 };
+        uint64_t oddPart = 1;
+        int64_t exponent = 0;
+        for( uint64_t k = 1; k <= n; k++ )
         {
-            extrapolations.push_back( extrapolations.back()
-                | std::views::adjacent<2>
-                | std::views::transform( [] ( auto tuple ) { return std::get<1>( tuple ) - std::get<0>( tuple ); } )
-                | std::ranges::to<std::vector>() );
+            const auto factorExponent = std::countr_zero( n - k + 1 );
+            const auto divisorExponent = std::countr_zero( k );
+            oddPart *= ( ( n - k + 1 ) >> factorExponent ) * getInverse( k >> divisorExponent );
+            exponent += factorExponent - divisorExponent;
+            binomials.push_back( exponent < 64 ? oddPart << exponent : 0 );
         }
+        return binomials;
+    }
 
-        int64_t extrapolatedValue = 0;
+    Weights getWeights( size_t length )
+    {
+        const auto binomials = getBinomials( length );
+        Weights weights;
+        for( size_t index = 0; index < length; index++ )
+        {
+            weights.next.push_back( ( length - 1 - index ) % 2 == 0 ? binomials[ index ] : 0 - binomials[ index ] );
+            weights.previous.push_back( index % 2 == 0 ? binomials[ index + 1 ] : 0 - binomials[ index + 1 ] );
+        }
+        return weights;
+    }
 
-        for( auto& extrapolation : extrapolations | std::views::reverse )
-            extrapolatedValue = extrapolation.front() - extrapolatedValue;
+    struct Extrapolation
+    {
+        int64_t next = 0;
+        int64_t previous = 0;
+    };
 
-        return extrapolatedValue;
+    Extrapolation getExtrapolation( History history, const Weights& weights )
+    {
+        uint64_t next = 0;
+        uint64_t previous = 0;
+        for( size_t index = 0; index < history.size(); index++ )
+        {
+            next += weights.next[ index ] * static_cast<uint64_t>( history[ index ] );
+            previous += weights.previous[ index ] * static_cast<uint64_t>( history[ index ] );
+        }
+        return { static_cast<int64_t>( next ), static_cast<int64_t>( previous ) };
     }
 
-    int64_t getSumOfNegativeExtropolatedHistories( const std::vector<History>& histories )
+    Extrapolation getSumOfExtrapolations( const Histories& histories )
     {
-        return std::accumulate( histories.begin(), histories.end(), 0ll, [] ( auto sum, auto history ) { return sum + getNegativeExtrapolatedValue( history ); } );
+        // only the lengths that occur, a single long history must not cost a row for every shorter length
+        std::map<size_t, Weights> weights;
+        for( size_t index = 0; index < histories.size(); index++ )
+        {
+            if( const auto length = histories.get( index ).size(); !weights.contains( length ) )
+                weights.emplace( length, getWeights( length ) );
+        }
+
+        return parallelMapReduce( std::views::iota( size_t{ 0 }, histories.size() ), Extrapolation{},
+            [ & ] ( size_t index ) {
+                const auto history = histories.get( index );
+                return getExtrapolation( history, weights.at( history.size() ) );
+                },
+            [] ( const Extrapolation& lhs, const Extrapolation& rhs ) { return Extrapolation{ lhs.next + rhs.next, lhs.previous + rhs.previous }; } );
     }
 }
 
-void executeDay9()
+DayResult solveDay9( const InputFile& input, const PhaseCallback& onPhaseDone )
 {
-    std::ifstream file( "input/Day9.txt" );
-    auto histories = Day9::parseInput( file );
-    fmt::print( "Sum of extrapolated history values: {}\n", Day9::getSumOfExtropolatedHistories( histories ) );
-    fmt::print( "Sum of negative extrapolated history values: {}\n", Day9::getSumOfNegativeExtropolatedHistories( histories ) );
+    auto histories = Day9::parseInput( input.getLines() );
+    onPhaseDone( Phase::Parse );
+
+    // both directions are extrapolated in the same pass, so part 2 is already done when part 1 is
+    DayResult result;
+    const auto [next, previous] = Day9::getSumOfExtrapolations( histories );
+    result.part1 = next;
+    onPhaseDone( Phase::Part1 );
+    result.part2 = previous;
+    onPhaseDone( Phase::Part2 );
+    return result;
 }
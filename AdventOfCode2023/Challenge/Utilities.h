@@ -1,10 +1,407 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <bitset>
 #include <fstream>
+#include <functional>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <optional>
+#include <iostream>
+#include <iterator>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <span>
+#include <filesystem>
+#include <utility>
 #include <vector>
 #include <ranges>
 #include <algorithm>
 #include <numeric>
 #include <fmt/core.h>
-#include <regex>
 #include <map>
 #include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole input file together with an index of its lines.
+// Regular files are memory mapped, everything else (pipes, "-" for stdin) is read into an owned buffer.
+class InputFile
+{
+public:
+    explicit InputFile( const std::filesystem::path& path )
+    {
+        if( path == "-" )
+            readStream( std::cin );
+        else if( !mapFile( path ) )
+        {
+            std::ifstream stream( path, std::ios::binary );
+            if( !stream )
+                throw std::runtime_error( "could not open input file" );
+            readStream( stream );
+        }
+        indexLines();
+    }
+
+    explicit InputFile( std::istream& stream )
+    {
+        readStream( stream );
+        indexLines();
+    }
+
+    InputFile( const InputFile& ) = delete;
+    InputFile& operator=( const InputFile& ) = delete;
+
+    ~InputFile()
+    {
+        if( !m_mapping )
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile( m_mapping );
+#else
+        munmap( m_mapping, m_data.size() );
+#endif
+    }
+
+    std::string_view getData() const
+    {
+        return m_data;
+    }
+
+    const std::vector<std::string_view>& getLines() const
+    {
+        return m_lines;
+    }
+
+private:
+    bool mapFile( const std::filesystem::path& path )
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileW( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+        if( file == INVALID_HANDLE_VALUE )
+            return false;
+        LARGE_INTEGER size{};
+        if( GetFileType( file ) != FILE_TYPE_DISK || !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+        {
+            CloseHandle( file );
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        CloseHandle( file );
+        if( !mapping )
+            return false;
+        m_mapping = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+        CloseHandle( mapping );
+        if( !m_mapping )
+            return false;
+        m_data = { static_cast<const char*>( m_mapping ), static_cast<size_t>( size.QuadPart ) };
+#else
+        int file = open( path.c_str(), O_RDONLY );
+        if( file < 0 )
+            return false;
+        struct stat status{};
+        if( fstat( file, &status ) != 0 || !S_ISREG( status.st_mode ) || status.st_size == 0 )
+        {
+            close( file );
+            return false;
+        }
+        void* mapping = mmap( nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+        close( file );
+        if( mapping == MAP_FAILED )
+            return false;
+        madvise( mapping, status.st_size, MADV_SEQUENTIAL );
+        m_mapping = mapping;
+        m_data = { static_cast<const char*>( m_mapping ), static_cast<size_t>( status.st_size ) };
+#endif
+        return true;
+    }
+
+    void readStream( std::istream& stream )
+    {
+        m_buffer.assign( std::istreambuf_iterator<char>( stream ), std::istreambuf_iterator<char>() );
+        m_data = { m_buffer.data(), m_buffer.size() };
+    }
+
+    // Splits like std::getline: no empty entry after a final newline, trailing '\r' removed.
+    void indexLines()
+    {
+        for( size_t lineStart = 0; lineStart < m_data.size(); )
+        {
+            auto lineEnd = m_data.find( '\n', lineStart );
+            if( lineEnd == std::string_view::npos )
+                lineEnd = m_data.size();
+            auto line = m_data.substr( lineStart, lineEnd - lineStart );
+            if( line.ends_with( '\r' ) )
+                line.remove_suffix( 1 );
+            m_lines.push_back( line );
+            lineStart = lineEnd + 1;
+        }
+    }
+
+    void* m_mapping = nullptr;
+    std::vector<char> m_buffer;
+    std::string_view m_data;
+    std::vector<std::string_view> m_lines;
+};
+
+// Allocation-free cursor over a line for hand-written parsers.
+class Scanner
+{
+public:
+    explicit Scanner( std::string_view text )
+        : m_text( text )
+    {
+    }
+
+    bool atEnd() const
+    {
+        return m_text.empty();
+    }
+
+    std::string_view getRemaining() const
+    {
+        return m_text;
+    }
+
+    // Consumes the literal if the remaining text starts with it.
+    bool expect( std::string_view literal )
+    {
+        if( !m_text.starts_with( literal ) )
+            return false;
+        m_text.remove_prefix( literal.size() );
+        return true;
+    }
+
+    // Returns whether at least one space was skipped.
+    bool skipSpaces()
+    {
+        const auto numSpaces = std::min( m_text.find_first_not_of( ' ' ), m_text.size() );
+        m_text.remove_prefix( numSpaces );
+        return numSpaces > 0;
+    }
+
+    std::optional<int64_t> readUnsigned()
+    {
+        if( atEnd() || m_text.front() < '0' || m_text.front() > '9' )
+            return std::nullopt;
+        int64_t value = 0;
+        auto [end, error] = std::from_chars( m_text.data(), m_text.data() + m_text.size(), value );
+        if( error != std::errc{} )
+            return std::nullopt;
+        m_text.remove_prefix( end - m_text.data() );
+        return value;
+    }
+
+    // Like readUnsigned, but also accepts a leading minus sign.
+    std::optional<int64_t> readInteger()
+    {
+        const auto digits = m_text.substr( m_text.starts_with( '-' ) ? 1 : 0 );
+        if( digits.empty() || digits.front() < '0' || digits.front() > '9' )
+            return std::nullopt;
+        int64_t value = 0;
+        auto [end, error] = std::from_chars( m_text.data(), m_text.data() + m_text.size(), value );
+        if( error != std::errc{} )
+            return std::nullopt;
+        m_text.remove_prefix( end - m_text.data() );
+        return value;
+    }
+
+    // Reads a run of word characters ([A-Za-z0-9_]), empty if there is none.
+    std::string_view readWord()
+    {
+        auto isWordChar = [] ( char c ) { return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) || c == '_'; };
+        const auto length = std::ranges::find_if_not( m_text, isWordChar ) - m_text.begin();
+        auto word = m_text.substr( 0, length );
+        m_text.remove_prefix( length );
+        return word;
+    }
+
+private:
+    std::string_view m_text;
+};
+
+// Fixed set of worker threads shared by every parallelFor, including the ones nested inside of other parallel tasks, so
+// the whole program never runs more than getNumThreads() threads at once. The calling thread always works on its own job
+// as well, which lets nested jobs finish even when every worker is busy.
+class ThreadPool
+{
+public:
+    static ThreadPool& getInstance()
+    {
+        static ThreadPool threadPool;
+        return threadPool;
+    }
+
+    ~ThreadPool()
+    {
+        stopWorkers();
+    }
+
+    size_t getNumThreads() const
+    {
+        return m_workers.size() + 1;
+    }
+
+    // Must not be called while a job is running.
+    void setNumThreads( size_t numThreads )
+    {
+        stopWorkers();
+        startWorkers( std::max<size_t>( numThreads, 1 ) - 1 );
+    }
+
+    // Runs task( index ) for every index in [0, count) on up to maxThreads threads.
+    // The first exception thrown by a task is rethrown once all threads have finished.
+    void run( size_t count, size_t maxThreads, const std::function<void( size_t )>& task )
+    {
+        Job job{ count, std::clamp<size_t>( maxThreads, 1, std::max<size_t>( count, 1 ) ) - 1, task, 0, 0, nullptr };
+        if( job.maxHelpers > 0 )
+        {
+            {
+                std::scoped_lock lock( m_mutex );
+                m_jobs.push_back( &job );
+            }
+            m_jobAdded.notify_all();
+        }
+        work( job );
+        {
+            std::unique_lock lock( m_mutex );
+            std::erase( m_jobs, &job );
+            m_helperDone.wait( lock, [ & ] { return job.numHelpers == 0; } );
+        }
+        if( job.error )
+            std::rethrow_exception( job.error );
+    }
+
+private:
+    struct Job
+    {
+        size_t count = 0;
+        size_t maxHelpers = 0;
+        const std::function<void( size_t )>& task;
+        std::atomic<size_t> nextIndex = 0;
+        size_t numHelpers = 0; // guarded by m_mutex
+        std::exception_ptr error; // guarded by m_mutex
+    };
+
+    ThreadPool()
+    {
+        startWorkers( std::max( std::thread::hardware_concurrency(), 1u ) - 1 );
+    }
+
+    void startWorkers( size_t numWorkers )
+    {
+        m_stop = false;
+        for( size_t worker = 0; worker < numWorkers; worker++ )
+            m_workers.emplace_back( [ this ] { runWorker(); } );
+    }
+
+    void stopWorkers()
+    {
+        {
+            std::scoped_lock lock( m_mutex );
+            m_stop = true;
+        }
+        m_jobAdded.notify_all();
+        m_workers.clear();
+    }
+
+    // Needs m_mutex to be locked.
+    Job* findJob() const
+    {
+        auto job = std::ranges::find_if( m_jobs, [] ( Job* candidate ) {
+            return candidate->numHelpers < candidate->maxHelpers && candidate->nextIndex < candidate->count;
+            } );
+        return job != m_jobs.end() ? *job : nullptr;
+    }
+
+    void runWorker()
+    {
+        std::unique_lock lock( m_mutex );
+        while( true )
+        {
+            Job* job = nullptr;
+            m_jobAdded.wait( lock, [ & ] { return m_stop || ( job = findJob() ) != nullptr; } );
+            if( m_stop )
+                return;
+
+            job->numHelpers++;
+            lock.unlock();
+            work( *job );
+            lock.lock();
+            job->numHelpers--;
+            m_helperDone.notify_all();
+        }
+    }
+
+    void work( Job& job )
+    {
+        for( size_t index = job.nextIndex++; index < job.count; index = job.nextIndex++ )
+        {
+            try
+            {
+                job.task( index );
+            }
+            catch( ... )
+            {
+                std::scoped_lock lock( m_mutex );
+                if( !job.error )
+                    job.error = std::current_exception();
+            }
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_jobAdded;
+    std::condition_variable m_helperDone;
+    std::vector<Job*> m_jobs;
+    bool m_stop = false;
+    std::vector<std::jthread> m_workers;
+};
+
+// Runs task( index ) for every index in [0, count) on up to numThreads threads of the shared pool.
+inline void parallelFor( size_t count, size_t numThreads, const std::function<void( size_t )>& task )
+{
+    ThreadPool::getInstance().run( count, numThreads, task );
+}
+
+// Runs task( index ) for every index in [0, count) on all threads of the shared pool.
+inline void parallelFor( size_t count, const std::function<void( size_t )>& task )
+{
+    parallelFor( count, ThreadPool::getInstance().getNumThreads(), task );
+}
+
+// Splits a random access range into chunks, folds map( item ) over every chunk on its own thread and combines the partial
+// results in chunk order. identity has to be the neutral element of reduce since every chunk starts from it.
+template<std::ranges::random_access_range Range, typename Result, typename Map, typename Reduce = std::plus<>>
+    requires std::ranges::sized_range<const Range>
+Result parallelMapReduce( const Range& range, Result identity, Map map, Reduce reduce = {} )
+{
+    constexpr size_t minChunkSize = 4096;
+    const size_t numItems = std::ranges::size( range );
+    const size_t numChunks = std::clamp<size_t>( numItems / minChunkSize, 1, ThreadPool::getInstance().getNumThreads() * 4 );
+
+    std::vector<Result> partials( numChunks, identity );
+    parallelFor( numChunks, [ & ] ( size_t chunk ) {
+        const auto begin = numItems * chunk / numChunks;
+        const auto end = numItems * ( chunk + 1 ) / numChunks;
+        for( auto&& item : range | std::views::drop( begin ) | std::views::take( end - begin ) )
+            partials[ chunk ] = reduce( std::move( partials[ chunk ] ), map( item ) );
+        } );
+    return std::accumulate( partials.begin(), partials.end(), identity, reduce );
+}
@@ -1,12 +1,68 @@
 #pragma once
 
-void executeDay1();
-void executeDay2();
-void executeDay3();
-void executeDay4();
-void executeDay5();
-void executeDay6();
-void executeDay7();
-void executeDay8();
-void executeDay9();
-void executeDay10();
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+class InputFile;
+
+enum class Phase
+{
+    Parse,
+    Part1,
+    Part2,
+    Details // only reported when a day is solved with details
+};
+
+// Called whenever a phase of a solve has finished, used to time the phases separately.
+using PhaseCallback = std::function<void( Phase )>;
+
+inline void ignorePhase( Phase )
+{
+}
+
+struct DayResult
+{
+    int64_t part1 = 0;
+    int64_t part2 = 0;
+    std::string details; // further results besides the answers, only filled by solveWithDetails
+};
+
+DayResult solveDay1( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay2( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay3( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay4( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay5( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay6( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay7( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay8( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay9( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay10( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+DayResult solveDay10WithDetails( const InputFile& input, const PhaseCallback& onPhaseDone = ignorePhase );
+
+struct Challenge
+{
+    int day = 0;
+    DayResult( *solve )( const InputFile&, const PhaseCallback& ) = nullptr;
+    DayResult( *solveWithDetails )( const InputFile&, const PhaseCallback& ) = nullptr; // optional, also fills details
+};
+
+inline constexpr std::array challenges = {
+    Challenge{ 1, &solveDay1 },
+    Challenge{ 2, &solveDay2 },
+    Challenge{ 3, &solveDay3 },
+    Challenge{ 4, &solveDay4 },
+    Challenge{ 5, &solveDay5 },
+    Challenge{ 6, &solveDay6 },
+    Challenge{ 7, &solveDay7 },
+    Challenge{ 8, &solveDay8 },
+    Challenge{ 9, &solveDay9 },
+    Challenge{ 10, &solveDay10, &solveDay10WithDetails }
+};
+
+inline std::filesystem::path getDefaultInputPath( int day, const std::filesystem::path& directory = "input" )
+{
+    return directory / ( "Day" + std::to_string( day ) + ".txt" );
+}
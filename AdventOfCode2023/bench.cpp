@@ -0,0 +1,160 @@
+#include "Challenges.h"
+#include "Challenge/Utilities.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        int64_t repetitions = 10;
+        int64_t day = 0; // 0 runs all days
+        std::optional<std::filesystem::path> inputPath;
+        std::filesystem::path inputDirectory = "input";
+        bool withDetails = false;
+    };
+
+    void printUsage()
+    {
+        fmt::print( stderr, "Usage: AdventOfCode2023_bench [--repetitions N] [--day N [--input PATH] | --all] [--input-dir DIR] [--details]\n" );
+    }
+
+    Options parseOptions( std::span<char*> arguments )
+    {
+        Options options;
+        for( auto argument = arguments.begin(); argument != arguments.end(); argument++ )
+        {
+            const std::string_view name = *argument;
+            auto getValue = [ & ] {
+                if( std::next( argument ) == arguments.end() )
+                    throw std::runtime_error( fmt::format( "missing value for {}", name ) );
+                return std::string_view{ *++argument };
+                };
+            auto getNumber = [ & ] {
+                const auto value = getValue();
+                Scanner scanner( value );
+                const auto number = scanner.readUnsigned();
+                if( !number || !scanner.atEnd() )
+                    throw std::runtime_error( fmt::format( "invalid value for {}: {}", name, value ) );
+                return *number;
+                };
+
+            if( name == "--repetitions" )
+                options.repetitions = getNumber();
+            else if( name == "--day" )
+                options.day = getNumber();
+            else if( name == "--input" )
+                options.inputPath = getValue();
+            else if( name == "--input-dir" )
+                options.inputDirectory = getValue();
+            else if( name == "--all" )
+                options.day = 0;
+            else if( name == "--details" )
+                options.withDetails = true;
+            else
+                throw std::runtime_error( fmt::format( "unknown argument: {}", name ) );
+        }
+
+        if( options.repetitions < 1 )
+            throw std::runtime_error( "repetitions has to be at least 1" );
+        if( options.day != 0 && std::ranges::none_of( challenges, [ & ] ( auto& challenge ) { return challenge.day == options.day; } ) )
+            throw std::runtime_error( fmt::format( "no such day: {}", options.day ) );
+        if( options.inputPath && options.day == 0 )
+            throw std::runtime_error( "--input requires --day" );
+        return options;
+    }
+
+    constexpr std::array<std::string_view, 5> phaseNames = { "load", "parse", "part 1", "part 2", "details" };
+
+    using Samples = std::array<std::vector<double>, phaseNames.size()>;
+
+    struct Statistics
+    {
+        double min = 0;
+        double median = 0;
+        double p99 = 0;
+    };
+
+    Statistics getStatistics( std::vector<double> samples )
+    {
+        std::ranges::sort( samples );
+        const auto p99Index = static_cast<size_t>( std::ceil( samples.size() * 0.99 ) ) - 1;
+        return { samples.front(), samples[ samples.size() / 2 ], samples[ std::min( p99Index, samples.size() - 1 ) ] };
+    }
+
+    double toSeconds( Clock::duration duration )
+    {
+        return std::chrono::duration<double>( duration ).count();
+    }
+
+    void benchmarkDay( const Challenge& challenge, const std::filesystem::path& path, int64_t repetitions, bool withDetails )
+    {
+        const auto solve = withDetails && challenge.solveWithDetails ? challenge.solveWithDetails : challenge.solve;
+        Samples samples;
+        DayResult result;
+        size_t numLines = 0;
+        size_t numBytes = 0;
+
+        for( int64_t repetition = 0; repetition < repetitions; repetition++ )
+        {
+            auto phaseStart = Clock::now();
+            InputFile input( path );
+            auto now = Clock::now();
+            samples[ 0 ].push_back( toSeconds( now - phaseStart ) );
+            phaseStart = now;
+
+            result = solve( input, [ & ] ( Phase phase ) {
+                now = Clock::now();
+                samples[ static_cast<size_t>( phase ) + 1 ].push_back( toSeconds( now - phaseStart ) );
+                phaseStart = Clock::now();
+                } );
+            numLines = input.getLines().size();
+            numBytes = input.getData().size();
+        }
+
+        fmt::print( "Day{}: {} lines, {:.2f} MB, {} repetitions, results {} / {}\n", challenge.day, numLines, numBytes / 1e6, repetitions, result.part1, result.part2 );
+        if( !result.details.empty() )
+            fmt::print( "  {}\n", result.details );
+        fmt::print( "  {:<8}{:>14}{:>14}{:>14}{:>16}{:>12}\n", "phase", "min [ms]", "median [ms]", "p99 [ms]", "lines/s", "MB/s" );
+        for( size_t phase = 0; phase < samples.size(); phase++ )
+        {
+            if( samples[ phase ].empty() )
+                continue;
+            const auto [min, median, p99] = getStatistics( samples[ phase ] );
+            fmt::print( "  {:<8}{:>14.3f}{:>14.3f}{:>14.3f}{:>16.0f}{:>12.1f}\n", phaseNames[ phase ], min * 1e3, median * 1e3, p99 * 1e3, numLines / median, numBytes / 1e6 / median );
+        }
+    }
+}
+
+int main( int argc, char** argv )
+{
+    Options options;
+    try
+    {
+        options = parseOptions( { argv + 1, argv + argc } );
+    }
+    catch( const std::exception& exception )
+    {
+        fmt::print( stderr, "{}\n", exception.what() );
+        printUsage();
+        return 1;
+    }
+
+    for( auto& challenge : challenges )
+    {
+        if( options.day != 0 && challenge.day != options.day )
+            continue;
+        try
+        {
+            benchmarkDay( challenge, options.inputPath.value_or( getDefaultInputPath( challenge.day, options.inputDirectory ) ), options.repetitions, options.withDetails );
+        }
+        catch( const std::exception& exception )
+        {
+            fmt::print( stderr, "Day{}: error: {}\n", challenge.day, exception.what() );
+            return 1;
+        }
+    }
+}
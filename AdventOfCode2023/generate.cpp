@@ -0,0 +1,516 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+
+#include "Challenge/Utilities.h"
+
+namespace
+{
+    using Random = std::mt19937_64;
+
+    int64_t getUniform( Random& random, int64_t min, int64_t max )
+    {
+        return std::uniform_int_distribution<int64_t>( min, max )( random );
+    }
+
+    bool getChance( Random& random, double probability )
+    {
+        return std::bernoulli_distribution( probability )( random );
+    }
+
+    template<typename T>
+    const T& getAny( Random& random, std::span<const T> values )
+    {
+        return values[ getUniform( random, 0, ssize( values ) - 1 ) ];
+    }
+
+    // Buffered writer to stdout, inputs can be far larger than memory.
+    class Output
+    {
+    public:
+        ~Output()
+        {
+            flush();
+        }
+
+        template<typename... Args>
+        void print( fmt::format_string<Args...> format, Args&&... args )
+        {
+            fmt::format_to( std::back_inserter( m_buffer ), format, std::forward<Args>( args )... );
+            if( m_buffer.size() > ( 1 << 20 ) )
+                flush();
+        }
+
+        void put( char c )
+        {
+            m_buffer.push_back( c );
+            if( m_buffer.size() > ( 1 << 20 ) )
+                flush();
+        }
+
+        void flush()
+        {
+            std::fwrite( m_buffer.data(), 1, m_buffer.size(), stdout );
+            m_buffer.clear();
+        }
+
+    private:
+        std::string m_buffer;
+    };
+
+    // size: number of lines
+    void generateDay1( Output& output, Random& random, int64_t size )
+    {
+        constexpr std::array<std::string_view, 9> digitWords = { "one", "two", "three", "four", "five", "six", "seven", "eight", "nine" };
+        constexpr std::string_view letters = "abcdefghijklmnopqrstuvwxyz";
+        for( int64_t line = 0; line < size; line++ )
+        {
+            std::string text;
+            bool hasDigit = false;
+            for( int64_t token = getUniform( random, 2, 12 ); token > 0; token-- )
+            {
+                if( const auto kind = getUniform( random, 0, 9 ); kind < 2 )
+                {
+                    text += static_cast<char>( '1' + getUniform( random, 0, 8 ) );
+                    hasDigit = true;
+                }
+                else if( kind < 5 )
+                    text += getAny<std::string_view>( random, digitWords );
+                else
+                    text += letters[ getUniform( random, 0, ssize( letters ) - 1 ) ];
+            }
+            // part 1 needs at least one real digit per line
+            if( !hasDigit )
+                text.insert( text.begin() + getUniform( random, 0, ssize( text ) ), static_cast<char>( '1' + getUniform( random, 0, 8 ) ) );
+            output.print( "{}\n", text );
+        }
+    }
+
+    // size: number of games
+    void generateDay2( Output& output, Random& random, int64_t size )
+    {
+        constexpr std::array<std::string_view, 3> colors = { "red", "green", "blue" };
+        for( int64_t game = 1; game <= size; game++ )
+        {
+            output.print( "Game {}:", game );
+            for( int64_t pass = getUniform( random, 1, 6 ); pass > 0; pass-- )
+            {
+                std::array<size_t, 3> order = { 0, 1, 2 };
+                std::ranges::shuffle( order, random );
+                const auto numColors = getUniform( random, 1, 3 );
+                for( int64_t color = 0; color < numColors; color++ )
+                    output.print( " {} {}{}", getUniform( random, 1, 20 ), colors[ order[ color ] ], color + 1 < numColors ? "," : "" );
+                if( pass > 1 )
+                    output.put( ';' );
+            }
+            output.put( '\n' );
+        }
+    }
+
+    // size: width and height of the schematic
+    void generateDay3( Output& output, Random& random, int64_t size )
+    {
+        constexpr std::string_view symbols = "*#+$/@%=&-";
+        for( int64_t y = 0; y < size; y++ )
+        {
+            std::string row;
+            while( ssize( row ) < size )
+            {
+                if( const auto kind = getUniform( random, 0, 9 ); kind < 3 && ssize( row ) + 4 <= size )
+                    row += fmt::format( "{}.", getUniform( random, 1, 999 ) );
+                else if( kind < 4 )
+                    row += getChance( random, 0.4 ) ? '*' : symbols[ getUniform( random, 1, ssize( symbols ) - 1 ) ];
+                else
+                    row += '.';
+            }
+            row.resize( size );
+            output.print( "{}\n", row );
+        }
+    }
+
+    // size: number of cards
+    void generateDay4( Output& output, Random& random, int64_t size )
+    {
+        constexpr int64_t numWinning = 10, numGame = 25;
+        const auto idWidth = fmt::formatted_size( "{}", size );
+        std::vector<int64_t> numbers( 99 );
+        std::iota( numbers.begin(), numbers.end(), 1 );
+        for( int64_t card = 1; card <= size; card++ )
+        {
+            // matches follow a geometric distribution with mean < 1 so that the card copies of part 2 stay bounded,
+            // and may never copy past the last card
+            int64_t numMatches = 0;
+            while( numMatches < std::min( numWinning, size - card ) && getChance( random, 0.4 ) )
+                numMatches++;
+
+            std::ranges::shuffle( numbers, random );
+            auto winning = std::span( numbers ).first( numWinning );
+            std::vector<int64_t> game( winning.begin(), winning.begin() + numMatches );
+            game.insert( game.end(), numbers.begin() + numWinning, numbers.begin() + numWinning + numGame - numMatches );
+            std::ranges::shuffle( game, random );
+
+            output.print( "Card {:>{}}:", card, idWidth );
+            for( auto number : winning )
+                output.print( " {:>2}", number );
+            output.print( " |" );
+            for( auto number : game )
+                output.print( " {:>2}", number );
+            output.put( '\n' );
+        }
+    }
+
+    // size: number of sub-maps per stage, seed pairs scale with it
+    void generateDay5( Output& output, Random& random, int64_t size )
+    {
+        constexpr int64_t valueRange = 1ll << 32;
+        constexpr std::array<std::string_view, 7> mapNames = { "seed-to-soil", "soil-to-fertilizer", "fertilizer-to-water", "water-to-light", "light-to-temperature", "temperature-to-humidity", "humidity-to-location" };
+
+        output.print( "seeds:" );
+        for( int64_t seedPair = std::max<int64_t>( 10, size / 100 ); seedPair > 0; seedPair-- )
+        {
+            const auto start = getUniform( random, 0, valueRange - 1 );
+            output.print( " {} {}", start, getUniform( random, 1, std::min( valueRange - start, valueRange / 16 ) ) );
+        }
+        output.print( "\n" );
+
+        for( auto mapName : mapNames )
+        {
+            // every other interval between sorted cut points becomes a sub-map, the rest are identity gaps
+            std::vector<int64_t> cuts( 2 * size );
+            std::ranges::generate( cuts, [ & ] { return getUniform( random, 0, valueRange ); } );
+            std::ranges::sort( cuts );
+            std::vector<std::array<int64_t, 3>> subMaps;
+            for( size_t cut = 0; cut + 1 < cuts.size(); cut += 2 )
+            {
+                const auto length = cuts[ cut + 1 ] - cuts[ cut ];
+                if( length > 0 )
+                    subMaps.push_back( { getUniform( random, 0, valueRange - length ), cuts[ cut ], length } );
+            }
+            std::ranges::shuffle( subMaps, random );
+
+            output.print( "\n{} map:\n", mapName );
+            for( auto& [outputStart, inputStart, length] : subMaps )
+                output.print( "{} {} {}\n", outputStart, inputStart, length );
+        }
+    }
+
+    // size: number of races, at most 18
+    // Part 2 concatenates the times and the distances of all races into one int64_t, so the races share a budget of
+    // 18 digits. That also keeps the product of the part 1 counts, each at most time + 1, below 10^18.
+    void generateDay6( Output& output, Random& random, int64_t size )
+    {
+        constexpr int64_t maxDigits = 18;
+        const auto numRaces = std::min( size, maxDigits );
+        int64_t maxValue = 0;
+        for( int64_t digit = 0; digit < maxDigits / numRaces; digit++ )
+            maxValue = maxValue * 10 + 9;
+
+        std::vector<std::pair<int64_t, int64_t>> races( numRaces );
+        for( auto& [time, distance] : races )
+        {
+            // the best hold time reaches half * ( time - half ), which may not fit into 64 bits
+            time = getUniform( random, 2, maxValue );
+            const auto half = time / 2;
+            const auto maxDistance = half > maxValue / ( time - half ) ? maxValue : std::min( half * ( time - half ) - 1, maxValue );
+            distance = getUniform( random, 0, maxDistance );
+        }
+        output.print( "Time:    " );
+        for( auto& [time, distance] : races )
+            output.print( " {:>18}", time );
+        output.print( "\nDistance:" );
+        for( auto& [time, distance] : races )
+            output.print( " {:>18}", distance );
+        output.put( '\n' );
+    }
+
+    // size: number of hands
+    // Repeated hands get the bet of their first occurrence, otherwise the order of tied hands would change the winnings.
+    void generateDay7( Output& output, Random& random, int64_t size )
+    {
+        constexpr std::string_view cards = "AKQJT98765432";
+        std::unordered_map<std::string, int64_t> bets;
+        for( int64_t hand = 0; hand < size; hand++ )
+        {
+            // choose the number of distinct cards first, uniform cards would almost never give the rarer hand values
+            std::string ranks( cards );
+            std::ranges::shuffle( ranks, random );
+            const auto numDistinct = getUniform( random, 1, 5 );
+            std::string handCards = ranks.substr( 0, numDistinct );
+            while( ssize( handCards ) < 5 )
+                handCards += ranks[ getUniform( random, 0, numDistinct - 1 ) ];
+            std::ranges::shuffle( handCards, random );
+            const auto bet = bets.try_emplace( handCards, getUniform( random, 1, 1000 ) ).first->second;
+            output.print( "{} {}\n", handCards, bet );
+        }
+    }
+
+    // size: approximate number of nodes (at most ~44000 distinct three character ids exist)
+    void generateDay8( Output& output, Random& random, int64_t size )
+    {
+        constexpr std::string_view alphabet = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        constexpr std::array<int64_t, 16> cycleFactors = { 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61 };
+        const auto numNodes = std::clamp<int64_t>( size, 100, 43000 );
+
+        auto factors = std::vector<int64_t>( cycleFactors.begin(), cycleFactors.end() );
+        std::ranges::shuffle( factors, random );
+        factors.resize( std::min<int64_t>( 6, numNodes / 100 ) );
+        const auto factorSum = std::accumulate( factors.begin(), factors.end(), 0ll );
+        const auto numInstructions = std::max<int64_t>( 2, numNodes / ( factorSum + ssize( factors ) ) );
+
+        std::string instructions( numInstructions, 'L' );
+        for( auto& instruction : instructions )
+            instruction = getChance( random, 0.5 ) ? 'L' : 'R';
+
+        std::vector<std::string> ids, startIds, endIds;
+        for( auto a : alphabet )
+            for( auto b : alphabet )
+                for( auto c : alphabet )
+                    ( c == 'A' ? startIds : c == 'Z' ? endIds : ids ).push_back( { a, b, c } );
+        std::erase( startIds, "AAA" );
+        std::erase( endIds, "ZZZ" );
+        std::ranges::shuffle( ids, random );
+        std::ranges::shuffle( startIds, random );
+        std::ranges::shuffle( endIds, random );
+
+        // every ghost walks a tail into a cycle whose length is a multiple of the instruction length;
+        // all primary Z hits share one residue modulo the instruction length, so a common step always exists
+        struct Node
+        {
+            std::string id;
+            int64_t next = 0;
+            char direction = 'L';
+        };
+        std::vector<Node> nodes;
+        const auto residue = getUniform( random, 0, numInstructions - 1 );
+        for( size_t ghost = 0; ghost < factors.size(); ghost++ )
+        {
+            const auto tail = getUniform( random, 1, numInstructions );
+            const auto cycle = numInstructions * factors[ ghost ];
+            const auto firstNode = ssize( nodes );
+            const auto endIndex = tail + ( ( residue - tail ) % numInstructions + numInstructions ) % numInstructions + numInstructions * getUniform( random, 0, factors[ ghost ] - 1 );
+            const auto extraEndIndex = ghost > 0 && getChance( random, 0.5 ) ? getUniform( random, tail, tail + cycle - 1 ) : -1;
+            for( int64_t index = 0; index < tail + cycle; index++ )
+            {
+                std::string id;
+                if( index == 0 )
+                    id = ghost == 0 ? "AAA" : startIds[ ghost ];
+                else if( index == endIndex )
+                    id = ghost == 0 ? "ZZZ" : endIds[ 2 * ghost ];
+                else if( index == extraEndIndex )
+                    id = endIds[ 2 * ghost + 1 ];
+                else
+                {
+                    id = ids.back();
+                    ids.pop_back();
+                }
+                const auto next = index + 1 < tail + cycle ? index + 1 : tail;
+                nodes.push_back( { std::move( id ), firstNode + next, instructions[ index % numInstructions ] } );
+            }
+        }
+
+        output.print( "{}\n\n", instructions );
+        std::vector<size_t> order( nodes.size() );
+        std::iota( order.begin(), order.end(), 0 );
+        std::ranges::shuffle( order, random );
+        for( auto index : order )
+        {
+            // the branch that is never taken points anywhere
+            auto& node = nodes[ index ];
+            auto& next = nodes[ node.next ].id;
+            auto& other = nodes[ getUniform( random, 0, ssize( nodes ) - 1 ) ].id;
+            if( node.direction == 'L' )
+                output.print( "{} = ({}, {})\n", node.id, next, other );
+            else
+                output.print( "{} = ({}, {})\n", node.id, other, next );
+        }
+    }
+
+    // size: number of histories
+    void generateDay9( Output& output, Random& random, int64_t size )
+    {
+        constexpr int64_t length = 21;
+        for( int64_t history = 0; history < size; history++ )
+        {
+            // value( i ) = sum_j coefficient_j * binomial( i, j ), a polynomial of degree numCoefficients - 1
+            std::vector<int64_t> coefficients( getUniform( random, 1, 9 ) );
+            std::ranges::generate( coefficients, [ & ] { return getUniform( random, -20, 20 ); } );
+            for( int64_t i = 0; i < length; i++ )
+            {
+                int64_t value = 0;
+                int64_t binomial = 1;
+                for( int64_t j = 0; j < ssize( coefficients ); j++ )
+                {
+                    value += coefficients[ j ] * binomial;
+                    binomial = binomial * ( i - j ) / ( j + 1 );
+                }
+                output.print( "{}{}", value, i + 1 < length ? ' ' : '\n' );
+            }
+        }
+    }
+
+    // size: width and height of the grid
+    //
+    // The loop is the boundary of a polyomino on the grid whose corners are the cell centers. The polyomino is a random
+    // tree of 2x2 blocks joined by 2x1 corridors, which is simply connected and never touches itself diagonally, so its
+    // boundary is one simple closed loop with enclosed cells.
+    void generateDay10( Output& output, Random& random, int64_t size )
+    {
+        size = std::max<int64_t>( size, 8 );
+        constexpr uint8_t inTree = 1, edgeRight = 2, edgeDown = 4;
+        const int64_t numBlocks = ( size - 5 ) / 3 + 1;
+        std::vector<uint8_t> blocks( numBlocks * numBlocks );
+        auto getBlock = [ & ] ( int64_t x, int64_t y ) -> uint8_t& { return blocks[ y * numBlocks + x ]; };
+
+        struct Edge
+        {
+            int64_t x, y, dx, dy;
+        };
+        std::vector<Edge> frontier;
+        constexpr std::array<std::pair<int64_t, int64_t>, 4> directions = { { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } } };
+        auto addBlock = [ & ] ( int64_t x, int64_t y ) {
+            getBlock( x, y ) |= inTree;
+            for( auto [dx, dy] : directions )
+                if( x + dx >= 0 && x + dx < numBlocks && y + dy >= 0 && y + dy < numBlocks )
+                    frontier.push_back( { x, y, dx, dy } );
+            };
+        addBlock( numBlocks / 2, numBlocks / 2 );
+        for( int64_t numInTree = 1, targetInTree = std::max<int64_t>( 1, numBlocks * numBlocks * 3 / 5 ); numInTree < targetInTree && !frontier.empty(); )
+        {
+            std::swap( frontier[ getUniform( random, 0, ssize( frontier ) - 1 ) ], frontier.back() );
+            const auto [x, y, dx, dy] = frontier.back();
+            frontier.pop_back();
+            if( getBlock( x + dx, y + dy ) & inTree )
+                continue;
+            getBlock( std::min( x, x + dx ), std::min( y, y + dy ) ) |= dx != 0 ? edgeRight : edgeDown;
+            addBlock( x + dx, y + dy );
+            numInTree++;
+        }
+        frontier = {};
+
+        // polyomino cells start at 1 so the loop keeps a border around it
+        auto isOccupied = [ & ] ( int64_t x, int64_t y ) {
+            if( x < 1 || y < 1 || x > 3 * numBlocks - 1 || y > 3 * numBlocks - 1 )
+                return false;
+            const auto blockX = ( x - 1 ) / 3, blockY = ( y - 1 ) / 3;
+            const bool isCorridorX = ( x - 1 ) % 3 == 2, isCorridorY = ( y - 1 ) % 3 == 2;
+            if( isCorridorX && isCorridorY )
+                return false;
+            if( isCorridorX )
+                return ( getBlock( blockX, blockY ) & edgeRight ) != 0;
+            if( isCorridorY )
+                return ( getBlock( blockX, blockY ) & edgeDown ) != 0;
+            return ( getBlock( blockX, blockY ) & inTree ) != 0;
+            };
+        auto getLoopElement = [ & ] ( int64_t x, int64_t y ) {
+            const bool north = isOccupied( x - 1, y - 1 ) != isOccupied( x, y - 1 );
+            const bool south = isOccupied( x - 1, y ) != isOccupied( x, y );
+            const bool west = isOccupied( x - 1, y - 1 ) != isOccupied( x - 1, y );
+            const bool east = isOccupied( x, y - 1 ) != isOccupied( x, y );
+            if( north && south )
+                return '|';
+            if( east && west )
+                return '-';
+            if( north )
+                return east ? 'L' : 'J';
+            if( south )
+                return east ? 'F' : '7';
+            return '\0';
+        };
+
+        // the top left corner of the topmost block is an F on the loop
+        int64_t startX = 0, startY = 0;
+        for( auto block = blocks.begin(); block != blocks.end(); block++ )
+        {
+            if( *block & inTree )
+            {
+                startX = 3 * ( ( block - blocks.begin() ) % numBlocks ) + 1;
+                startY = 3 * ( ( block - blocks.begin() ) / numBlocks ) + 1;
+                break;
+            }
+        }
+
+        constexpr std::string_view junk = "|-LJ7F.....";
+        for( int64_t y = 0; y < size; y++ )
+        {
+            for( int64_t x = 0; x < size; x++ )
+            {
+                // the cells next to the start must not look connected to it
+                const auto distanceToStart = std::abs( x - startX ) + std::abs( y - startY );
+                if( distanceToStart == 0 )
+                    output.put( 'S' );
+                else if( auto element = getLoopElement( x, y ); element != '\0' )
+                    output.put( element );
+                else
+                    output.put( distanceToStart == 1 ? '.' : junk[ getUniform( random, 0, ssize( junk ) - 1 ) ] );
+            }
+            output.put( '\n' );
+        }
+    }
+
+    struct Generator
+    {
+        int day = 0;
+        void( *generate )( Output&, Random&, int64_t ) = nullptr;
+    };
+
+    constexpr std::array generators = {
+        Generator{ 1, &generateDay1 },
+        Generator{ 2, &generateDay2 },
+        Generator{ 3, &generateDay3 },
+        Generator{ 4, &generateDay4 },
+        Generator{ 5, &generateDay5 },
+        Generator{ 6, &generateDay6 },
+        Generator{ 7, &generateDay7 },
+        Generator{ 8, &generateDay8 },
+        Generator{ 9, &generateDay9 },
+        Generator{ 10, &generateDay10 }
+    };
+}
+
+// Usage: AdventOfCode2023_generate day size [seed] > input.txt
+// The meaning of size depends on the day, see the comments of the generators.
+int main( int argc, char** argv )
+{
+    auto fail = [] ( std::string_view error ) {
+        if( !error.empty() )
+            fmt::print( stderr, "{}\n", error );
+        fmt::print( stderr, "Usage: AdventOfCode2023_generate day size [seed]\n" );
+        return 1;
+        };
+    if( argc < 3 || argc > 4 )
+        return fail( {} );
+
+    std::array<int64_t, 3> numbers = { 0, 0, 2023 };
+    constexpr std::array<std::string_view, 3> names = { "day", "size", "seed" };
+    for( int argument = 1; argument < argc; argument++ )
+    {
+        const std::string_view value = argv[ argument ];
+        Scanner scanner( value );
+        const auto number = scanner.readUnsigned();
+        if( !number || !scanner.atEnd() )
+            return fail( fmt::format( "invalid value for {}: {}", names[ argument - 1 ], value ) );
+        numbers[ argument - 1 ] = *number;
+    }
+    const auto [day, size, seed] = numbers;
+
+    auto generator = std::ranges::find( generators, day, &Generator::day );
+    if( generator == generators.end() )
+        return fail( fmt::format( "no generator for day {}", day ) );
+    if( size < 1 )
+        return fail( "size has to be at least 1" );
+
+    Random random( seed );
+    Output output;
+    generator->generate( output, random, size );
+}
@@ -1,6 +1,135 @@
 #include "Challenges.h"
+#include "Challenge/Utilities.h"
 
-int main()
+namespace
 {
-    executeDay10();
-}
\ No newline at end of file
+    struct Options
+    {
+        int64_t day = 0; // 0 runs all days
+        int64_t part = 0; // 0 prints both parts
+        std::optional<std::filesystem::path> inputPath;
+        int64_t numJobs = std::max<int64_t>( std::thread::hardware_concurrency(), 1 );
+        bool withDetails = false; // days that support it also report further results, at extra cost
+    };
+
+    void printUsage()
+    {
+        fmt::print( stderr, "Usage: AdventOfCode2023 [--day N [--input PATH] | --all] [--part 1|2] [--jobs K] [--details]\n" );
+    }
+
+    Options parseOptions( std::span<char*> arguments )
+    {
+        Options options;
+        for( auto argument = arguments.begin(); argument != arguments.end(); argument++ )
+        {
+            const std::string_view name = *argument;
+            auto getValue = [ & ] {
+                if( std::next( argument ) == arguments.end() )
+                    throw std::runtime_error( fmt::format( "missing value for {}", name ) );
+                return std::string_view{ *++argument };
+                };
+            auto getNumber = [ & ] {
+                const auto value = getValue();
+                Scanner scanner( value );
+                const auto number = scanner.readUnsigned();
+                if( !number || !scanner.atEnd() )
+                    throw std::runtime_error( fmt::format( "invalid value for {}: {}", name, value ) );
+                return *number;
+                };
+
+            if( name == "--day" )
+                options.day = getNumber();
+            else if( name == "--part" )
+            {
+                options.part = getNumber();
+                if( options.part < 1 || options.part > 2 )
+                    throw std::runtime_error( "part has to be 1 or 2" );
+            }
+            else if( name == "--input" )
+                options.inputPath = getValue();
+            else if( name == "--all" )
+                options.day = 0;
+            else if( name == "--jobs" )
+                options.numJobs = getNumber();
+            else if( name == "--details" )
+                options.withDetails = true;
+            else
+                throw std::runtime_error( fmt::format( "unknown argument: {}", name ) );
+        }
+
+        if( options.day != 0 && std::ranges::none_of( challenges, [ & ] ( auto& challenge ) { return challenge.day == options.day; } ) )
+            throw std::runtime_error( fmt::format( "no such day: {}", options.day ) );
+        if( options.inputPath && options.day == 0 )
+            throw std::runtime_error( "--input requires --day" );
+        if( options.numJobs < 1 )
+            throw std::runtime_error( "jobs has to be at least 1" );
+        return options;
+    }
+
+    struct Outcome
+    {
+        DayResult result;
+        std::string error;
+    };
+
+    Outcome runChallenge( const Challenge& challenge, const Options& options )
+    {
+        try
+        {
+            InputFile input( options.inputPath.value_or( getDefaultInputPath( challenge.day ) ) );
+            const auto solve = options.withDetails && challenge.solveWithDetails ? challenge.solveWithDetails : challenge.solve;
+            return { solve( input, ignorePhase ), {} };
+        }
+        catch( const std::exception& exception )
+        {
+            return { {}, exception.what() };
+        }
+    }
+
+    void printOutcome( int day, const Outcome& outcome, int64_t part )
+    {
+        if( !outcome.error.empty() )
+        {
+            fmt::print( "Day{}: error: {}\n", day, outcome.error );
+            return;
+        }
+        if( part != 2 )
+            fmt::print( "Day{} part 1: {}\n", day, outcome.result.part1 );
+        if( part != 1 )
+            fmt::print( "Day{} part 2: {}\n", day, outcome.result.part2 );
+        if( !outcome.result.details.empty() )
+            fmt::print( "Day{} details: {}\n", day, outcome.result.details );
+    }
+}
+
+int main( int argc, char** argv )
+{
+    Options options;
+    try
+    {
+        options = parseOptions( { argv + 1, argv + argc } );
+    }
+    catch( const std::exception& exception )
+    {
+        fmt::print( stderr, "{}\n", exception.what() );
+        printUsage();
+        return 1;
+    }
+
+    auto selectedChallenges = challenges
+        | std::views::filter( [ & ] ( auto& challenge ) { return options.day == 0 || challenge.day == options.day; } )
+        | std::ranges::to<std::vector>();
+
+    // days are independent, results are printed in day order once all are done. The days share the thread pool with
+    // their own parallel loops, so --jobs bounds the total number of threads.
+    ThreadPool::getInstance().setNumThreads( options.numJobs );
+    std::vector<Outcome> outcomes( selectedChallenges.size() );
+    parallelFor( selectedChallenges.size(), [ & ] ( size_t index ) {
+        outcomes[ index ] = runChallenge( selectedChallenges[ index ], options );
+        } );
+
+    for( auto [challenge, outcome] : std::views::zip( selectedChallenges, outcomes ) )
+        printOutcome( challenge.day, outcome, options.part );
+
+    return std::ranges::all_of( outcomes, [] ( auto& outcome ) { return outcome.error.empty(); } ) ? 0 : 1;
+}